@@ -1,21 +0,0 @@
-/* Applied Video Sequence Analysis (AVSA)
- *
- *	LAB1: Background Subtraction - Unix version
- *  ShowManyImages.hpp
- *
- * 	Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es) & Juan Carlos San Miguel (juancarlos.sanmiguel@uam.es)
- *	VPULab-UAM 2020
- *	Adapted from OpenSoruce (see below)
- */
-
-#ifndef SRC_SHOWMANYIMAGES_HPP_
-#define SRC_SHOWMANYIMAGES_HPP_
-
-#include <stdio.h>
-
-using namespace std;
-
-void ShowManyImages(string title, int nArgs, ...);
-
-
-#endif /* SRC_SHOWMANYIMAGES_HPP_ */
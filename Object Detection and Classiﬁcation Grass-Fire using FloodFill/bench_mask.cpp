@@ -0,0 +1,88 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Benchmark of the mask preprocessing and seed scan of the floodFill labeling backend
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+//system libraries C/C++
+#include <stdio.h>
+#include <iostream>
+
+//opencv libraries
+#include <opencv2/opencv.hpp>
+
+//include for blob-related functions
+#include "blobs.hpp"
+
+//include for the synthetic masks (shared with bench_blobs)
+#include "synthetic.hpp"
+
+//namespaces
+using namespace cv;
+using namespace std;
+
+#define NUM_REPETITIONS 50
+
+//previous preprocessing: copyMakeBorder followed by a column-major inversion
+static void prepareColumnMajor(const Mat &fgmask, Mat &temp_fgmask)
+{
+	copyMakeBorder(fgmask,temp_fgmask,1,1,1,1,BORDER_CONSTANT,0);
+	Size s_mask = temp_fgmask.size();
+	for (int x=0;x<s_mask.width;x++)
+		for (int y=0;y<s_mask.height;y++)
+			temp_fgmask.at<uchar>(y,x) = (temp_fgmask.at<uchar>(y,x)==255) ? 0 : 255;
+}
+
+//previous extraction: column-major seed scan over the prepared mask
+static int extractBlobsColumnMajor(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	Mat temp_fgmask;
+	prepareColumnMajor(fgmask, temp_fgmask);
+	bloblist.clear();
+	for (int x=1; x<=fgmask.cols; x++)
+		for (int y=1; y<=fgmask.rows; y++)
+			if (temp_fgmask.at<uchar>(y,x)==0)
+			{
+				Rect blob_temp;
+				floodFill(temp_fgmask, cvPoint(x,y),255,&blob_temp,0,0,connectivity);
+				bloblist.push_back(initBlob((int)bloblist.size(),blob_temp.x-1,blob_temp.y-1,blob_temp.width,blob_temp.height));
+			}
+	return 1;
+}
+
+//milliseconds per megapixel of 'fn' averaged over NUM_REPETITIONS
+template<typename F> static double msPerMegapixel(const Mat &mask, F fn)
+{
+	double t = (double)getTickCount();
+	for (int i=0; i<NUM_REPETITIONS; i++)
+		fn();
+	t = ((double)getTickCount() - t) / getTickFrequency();
+	return 1000.0*t / NUM_REPETITIONS / (mask.total()/1e6);
+}
+
+int main(int argc, char ** argv)
+{
+	Size sizes[3] = {Size(640,480), Size(1920,1080), Size(3840,2160)};
+
+	cout << "resolution, prep_before(ms/MP), prep_after(ms/MP), extract_before(ms/MP), extract_after(ms/MP), blobs" << endl;
+	for (int i=0; i<3; i++)
+	{
+		//20 rectangles covering 10% of the image, with shadows (as the bench_blobs defaults)
+		MaskSpec spec = { sizes[i], 0.1, 20, SHAPE_RECT, 0.25, 12345 };
+		Mat fgmask = syntheticMask(spec);
+		Mat temp_fgmask;
+		std::vector<cvBlob> bloblist;
+
+		double prep_before = msPerMegapixel(fgmask, [&]{ prepareColumnMajor(fgmask, temp_fgmask); });
+		double prep_after = msPerMegapixel(fgmask, [&]{ prepareFloodFillMask(fgmask, temp_fgmask); });
+		double ext_before = msPerMegapixel(fgmask, [&]{ extractBlobsColumnMajor(fgmask, bloblist, 8); });
+		double ext_after = msPerMegapixel(fgmask, [&]{ extractBlobs(fgmask, bloblist, 8, FLOODFILL); });
+
+		cout << sizes[i].width << "x" << sizes[i].height << ", " << prep_before << ", " << prep_after << ", "
+			 << ext_before << ", " << ext_after << ", " << bloblist.size() << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,211 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Batch processing of dataset sequences
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "batch.hpp"
+#include "results.hpp"
+#include "maskstream.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+/**
+ *	Reads the list of sequences of a batch run. Each line holds the input of a sequence (video
+ *	file or image pattern) and optionally the directory for its results. Without directory the
+ *	results go to 'results_path' in a folder named after the input ('/' replaced by '_'). A
+ *	third field selects the labeling backend of the sequence by name (see labelingBackends),
+ *	e.g. "in.avi - floodfill" ('-' keeps the default directory).
+ *
+ * \param list_path Text file with the sequences
+ * \param results_path Default root for the result directories
+ * \param jobs List of sequences found
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int readSequenceList(const std::string &list_path, const std::string &results_path, std::vector<SequenceJob> &jobs)
+{
+	std::ifstream list(list_path.c_str());
+	if (!list.is_open()){
+		std::cout << "Could not open sequence list " << list_path << std::endl;
+		return -1;
+	}
+
+	jobs.clear();
+	std::string line;
+	while (std::getline(list, line))
+	{
+		std::istringstream fields(line);
+		SequenceJob job;
+		job.labeling = NULL;
+		if (!(fields >> job.input) || job.input[0] == '#')
+			continue;
+		std::string labeling;
+		if (fields >> job.output_dir && fields >> labeling)
+		{
+			job.labeling = findLabelingBackend(labeling);
+			if (!job.labeling){
+				std::cout << list_path << ": unknown labeling backend " << labeling << std::endl;
+				return -1;
+			}
+		}
+		if (job.output_dir.empty() || job.output_dir == "-")
+		{
+			std::string name = job.input;
+			std::replace(name.begin(), name.end(), '/', '_');
+			job.output_dir = results_path + "/" + name;
+		}
+		jobs.push_back(job);
+	}
+	return 1;
+}
+
+//processes one sequence. Any error is reported in the result instead of stopping the batch
+static SequenceResult processJob(const SequenceJob &job, const PipelineConfig &config)
+{
+	SequenceResult result;
+	result.input = job.input;
+	result.ok = false;
+	result.frames = 0;
+	result.results_dropped = 0;
+	result.seconds = 0;
+
+	double t = (double)getTickCount();
+	try {
+		//reader, MOG2 model and stationary history belong to this worker only (with replay_masks
+		//the recorded masks are read instead of the input)
+		Ptr<FrameSource> source;
+		if (!config.replay_masks)
+			source = openFrameSource(job.input, config.prefetch, config.decode_workers);
+		if (!source && !config.replay_masks)
+			result.error = "could not open input";
+		else
+		{
+			std::string makedir_cmd = "mkdir -p \"" + job.output_dir + "\"";
+			if (system(makedir_cmd.c_str()) != 0)
+				result.error = "could not create " + job.output_dir;
+			else
+			{
+				PipelineConfig job_config = config;
+				if (job.labeling)
+					job_config.labeling = job.labeling->method;
+
+				PipelineStats stats;
+				ResultsWriter results;
+				results.open(job.output_dir, config.masks, config.blobs);
+				std::string mask_stream = job.output_dir + "/fgmask.rle";
+				if (config.replay_masks)
+				{
+					MaskReplay replay;
+					if (openMaskReplay(mask_stream, replay) < 0)
+						result.error = "could not read " + mask_stream;
+					else
+					{
+						result.frames = replayMasks(replay, job_config, stats, results.isOpened() ? &results : NULL);
+						result.ok = true;
+					}
+					closeMaskReplay(replay);
+				}
+				else
+				{
+					MaskRecorder recorder;
+					bool recording = config.record_masks && openMaskRecorder(mask_stream, config.analysis_scale, recorder) > 0;
+					result.frames = analyzeSequence(*source, job_config, stats, results.isOpened() ? &results : NULL, recording ? &recorder : NULL);
+					closeMaskRecorder(recorder);
+					result.ok = true;
+				}
+				results.close();
+				result.results_dropped = results.dropped();
+
+				//per-stage latency of the sequence
+				writeStatsCSV(job.output_dir + "/stage_latency.csv", stats);
+				writeStatsJSON(job.output_dir + "/stage_latency.json", stats);
+				writeSkipLogCSV(job.output_dir + "/skipped_frames.csv", stats);
+			}
+		}
+	}
+	catch (const std::exception &e) {
+		result.error = e.what();
+	}
+	result.seconds = ((double)getTickCount() - t) / getTickFrequency();
+	return result;
+}
+
+/**
+ *	Processes a list of sequences on a bounded pool of worker threads. Each worker takes the
+ *	next pending sequence until none is left, so at most 'num_workers' sequences run at the
+ *	same time. A failed sequence does not stop the others.
+ *
+ * \param jobs Sequences to process
+ * \param config Analysis settings shared by all the sequences
+ * \param num_workers Maximum number of sequences processed at the same time (0 uses all the cores)
+ * \param results Outcome of each sequence, in the order of 'jobs'
+ *
+ * \return Number of failed sequences
+ */
+int runBatch(const std::vector<SequenceJob> &jobs, const PipelineConfig &config, int num_workers, std::vector<SequenceResult> &results)
+{
+	if (num_workers <= 0)
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	num_workers = std::min(num_workers, (int)jobs.size());
+
+	results.assign(jobs.size(), SequenceResult());
+	std::atomic<int> next(0);
+
+	std::vector<std::thread> workers;
+	for (int w = 0; w < num_workers; w++)
+		workers.push_back(std::thread([&]{
+			for (int j = next++; j < (int)jobs.size(); j = next++)
+			{
+				results[j] = processJob(jobs[j], config);
+				std::cout << (results[j].ok ? "Done " : "FAILED ") << jobs[j].input << std::endl;
+			}
+		}));
+	for (size_t w = 0; w < workers.size(); w++)
+		workers[w].join();
+
+	int failed = 0;
+	for (size_t j = 0; j < results.size(); j++)
+		if (!results[j].ok)
+			failed++;
+	return failed;
+}
+
+/**
+ *	Prints the outcome of a batch run: frames and frames per second of each sequence,
+ *	the failed sequences with their reason, and the aggregate throughput.
+ *
+ * \param results Outcome of each sequence
+ * \param wall_seconds Duration of the whole batch
+ */
+void printBatchReport(const std::vector<SequenceResult> &results, double wall_seconds)
+{
+	long total_frames = 0;
+	int failed = 0;
+
+	std::cout << "sequence, frames, seconds, fps, results_dropped" << std::endl;
+	for (size_t j = 0; j < results.size(); j++)
+	{
+		const SequenceResult &r = results[j];
+		if (!r.ok)
+		{
+			failed++;
+			continue;
+		}
+		total_frames += r.frames;
+		std::cout << r.input << ", " << r.frames << ", " << r.seconds << ", " << (r.seconds > 0 ? r.frames/r.seconds : 0) << ", " << r.results_dropped << std::endl;
+	}
+	for (size_t j = 0; j < results.size(); j++)
+		if (!results[j].ok)
+			std::cout << "FAILED " << results[j].input << ": " << results[j].error << std::endl;
+
+	std::cout << results.size()-failed << "/" << results.size() << " sequences processed, " << total_frames << " frames in "
+			  << wall_seconds << " s (" << (wall_seconds > 0 ? total_frames/wall_seconds : 0) << " fps aggregate)" << std::endl;
+}
@@ -0,0 +1,51 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Batch processing of dataset sequences
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#ifndef BATCH_H_INCLUDE
+#define BATCH_H_INCLUDE
+
+#include <string>
+#include <vector>
+
+#include "pipeline.hpp"
+
+/// One sequence of a batch run
+struct SequenceJob {
+	std::string input;        /* video file or image pattern (e.g. .../input/in%06d.jpg) */
+	std::string output_dir;   /* directory for the results of the sequence           */
+	const LabelingBackend *labeling; /* labeling backend of the sequence (NULL: the one of the batch) */
+};
+
+/// Outcome of one sequence of a batch run
+struct SequenceResult {
+	std::string input;
+	bool ok;                  /* false if the sequence could not be processed */
+	std::string error;        /* reason of the failure                        */
+	int frames;               /* frames processed                             */
+	long results_dropped;     /* frames whose results were not written        */
+	double seconds;           /* processing time                              */
+};
+
+/*
+* Headers of batch functions
+*
+*/
+
+//reads a sequence list (one input per line, optionally followed by its output directory and
+//labeling backend; empty lines and lines starting with '#' are skipped). Returns -1 if the file
+//cannot be read or names an unknown backend
+int readSequenceList(const std::string &list_path, const std::string &results_path, std::vector<SequenceJob> &jobs);
+
+//processes all the jobs with at most 'num_workers' sequences at the same time
+int runBatch(const std::vector<SequenceJob> &jobs, const PipelineConfig &config, int num_workers, std::vector<SequenceResult> &results);
+
+//prints one line per sequence, the failures and the aggregate frames per second
+void printBatchReport(const std::vector<SequenceResult> &results, double wall_seconds);
+
+#endif
@@ -0,0 +1,182 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Microbenchmarks of the blob kernels on synthetic masks
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+//system libraries C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//opencv libraries
+#include <opencv2/opencv.hpp>
+
+//include for blob-related functions
+#include "blobs.hpp"
+
+//include for the class models
+#include "classifier.hpp"
+
+//include for the synthetic masks
+#include "synthetic.hpp"
+
+//namespaces
+using namespace cv;
+using namespace std;
+
+/// Time of a kernel over the repetitions
+struct Timing {
+	double mean;     /* seconds per call */
+	double stddev;
+};
+
+//runs 'fn' once to warm up and then 'reps' times, timing every call
+template<typename F> static Timing timeKernel(int reps, F fn)
+{
+	fn();
+	double sum = 0, sum2 = 0;
+	for (int r = 0; r < reps; r++)
+	{
+		int64 t = getTickCount();
+		fn();
+		double s = (getTickCount() - t) / getTickFrequency();
+		sum += s;
+		sum2 += s * s;
+	}
+	Timing timing;
+	timing.mean = sum / reps;
+	timing.stddev = sqrt(std::max(0.0, sum2 / reps - timing.mean * timing.mean));
+	return timing;
+}
+
+//one CSV row: kernel, its mean and standard deviation, ns per pixel and ns per blob
+static void report(const MaskSpec &spec, const char *kernel, const Timing &timing, size_t nblobs)
+{
+	static const char *shapes[] = { "rect", "ellipse", "noise" };
+	double ns = timing.mean * 1e9;
+	printf("%dx%d,%.3f,%d,%s,%.2f,%s,%.4f,%.4f,%.4f,%.2f\n", spec.size.width, spec.size.height, spec.density,
+			spec.nblobs, shapes[spec.shape], spec.shadow, kernel, timing.mean * 1e3, timing.stddev * 1e3,
+			ns / spec.size.area(), nblobs ? ns / nblobs : 0.0);
+}
+
+//times every kernel on the mask of 'spec'
+static void benchMask(const MaskSpec &spec, int reps)
+{
+	Mat fgmask = syntheticMask(spec);
+	std::vector<cvBlob> bloblist, filtered;
+
+	//registered labeling backends with both connectivities
+	for (const LabelingBackend *b = labelingBackends(); b->name; b++)
+		for (int connectivity = 4; connectivity <= 8; connectivity += 4)
+		{
+			Timing timing = timeKernel(reps, [&]{ b->extract(fgmask, bloblist, connectivity); });
+			string name = string("extractBlobs_") + b->name + (connectivity == 4 ? "_4" : "_8");
+			report(spec, name.c_str(), timing, bloblist.size());
+		}
+
+	//the other kernels work on the blobs of the reference labeling
+	extractBlobs(fgmask, bloblist, 8, UNIONFIND);
+	report(spec, "removeSmallBlobs", timeKernel(reps, [&]{ removeSmallBlobs(bloblist, filtered, 20, 20); }), bloblist.size());
+
+	//only the labels change, so the list is classified in place with reused scratch buffers
+	BlobList soa;
+	BlobFeatures features;
+	report(spec, "classifyBlobs", timeKernel(reps, [&]{ classifyBlobs(NULL, bloblist, soa, features); }), bloblist.size());
+
+	//history in steady state: the same mask every frame
+	Mat fgmask_history, sfgmask;
+	report(spec, "extractStationaryFG", timeKernel(reps, [&]{ extractStationaryFG(fgmask, fgmask_history, sfgmask); }), bloblist.size());
+
+	Mat frame = Mat::zeros(spec.size, CV_8UC3), painted;
+	report(spec, "paintBlobImage", timeKernel(reps, [&]{ painted = paintBlobImage(frame, bloblist, true); }), bloblist.size());
+}
+
+int main(int argc, char ** argv)
+{
+	//command line options (a single mask; without them a sweep of masks is run)
+	//	--size <W>x<H>    resolution (default 1920x1080)
+	//	--density <d>     fraction of foreground pixels (default 0.1)
+	//	--blobs <n>       number of blobs (default 50)
+	//	--shape <s>       rect, ellipse or noise (default rect)
+	//	--shadow <f>      fraction of each blob drawn as shadow, 127 (default 0.25)
+	//	--reps <n>        timed repetitions of each kernel (default 20)
+	//	--seed <n>        seed of the mask generator (default 12345)
+	MaskSpec spec = { Size(1920, 1080), 0.1, 50, SHAPE_RECT, 0.25, 12345 };
+	int reps = 20;
+	bool sweep = true;
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (a+1 >= argc) {
+			cout << "Missing value of option " << arg << endl;
+			return -1;
+		}
+		string value = argv[++a];
+		if (arg == "--size")
+			sscanf(value.c_str(), "%dx%d", &spec.size.width, &spec.size.height);
+		else if (arg == "--density")
+			spec.density = atof(value.c_str());
+		else if (arg == "--blobs")
+			spec.nblobs = atoi(value.c_str());
+		else if (arg == "--shape")
+			spec.shape = (value == "noise") ? SHAPE_NOISE : (value == "ellipse") ? SHAPE_ELLIPSE : SHAPE_RECT;
+		else if (arg == "--shadow")
+			spec.shadow = atof(value.c_str());
+		else if (arg == "--reps")
+			reps = std::max(1, atoi(value.c_str()));
+		else if (arg == "--seed")
+			spec.seed = strtoull(value.c_str(), NULL, 10);
+		else {
+			cout << "Unknown option " << arg << endl;
+			return -1;
+		}
+		if (arg != "--reps")
+			sweep = false;
+	}
+
+	printf("resolution,density,blobs,shape,shadow,kernel,mean_ms,stddev_ms,ns_per_pixel,ns_per_blob\n");
+	if (!sweep)
+	{
+		benchMask(spec, reps);
+		return 0;
+	}
+
+	//default sweep: resolution, density, blob count, shape and shadows varied one at a time
+	Size sizes[] = { Size(640, 480), Size(1920, 1080), Size(3840, 2160) };
+	for (int i = 0; i < 3; i++)
+	{
+		MaskSpec s = spec;
+		s.size = sizes[i];
+		benchMask(s, reps);
+	}
+	double densities[] = { 0.01, 0.3 };
+	for (int i = 0; i < 2; i++)
+	{
+		MaskSpec s = spec;
+		s.density = densities[i];
+		benchMask(s, reps);
+	}
+	int counts[] = { 5, 500 };
+	for (int i = 0; i < 2; i++)
+	{
+		MaskSpec s = spec;
+		s.nblobs = counts[i];
+		benchMask(s, reps);
+	}
+	MaskSpec s = spec;
+	s.shape = SHAPE_ELLIPSE;
+	benchMask(s, reps);
+	s.shape = SHAPE_NOISE;
+	benchMask(s, reps);
+	s = spec;
+	s.shadow = 0;
+	benchMask(s, reps);
+	return 0;
+}
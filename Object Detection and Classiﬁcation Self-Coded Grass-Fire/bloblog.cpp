@@ -0,0 +1,259 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Binary blob log and memory-mapped reader
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "bloblog.hpp"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//header of a file with records of 'record_size' bytes
+static BlobLogHeader make_header(uint32_t record_size)
+{
+	BlobLogHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BLOBLOG_MAGIC, sizeof(BLOBLOG_MAGIC));
+	header.version = BLOBLOG_VERSION;
+	header.record_size = record_size;
+	return header;
+}
+
+/**
+ *	Creates the two files of a blob log (see BlobLogReader) and writes their headers.
+ *
+ * \param path Record file (the index is path + ".idx")
+ * \param log Writer state
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int openBlobLog(const std::string &path, BlobLogWriter &log)
+{
+	closeBlobLog(log);
+	log.records = fopen(path.c_str(), "wb");
+	log.index = fopen((path + ".idx").c_str(), "wb");
+	if (!log.records || !log.index){
+		std::cout << "Could not create blob log " << path << std::endl;
+		closeBlobLog(log);
+		return -1;
+	}
+
+	BlobLogHeader records_header = make_header(sizeof(BlobRecord));
+	BlobLogHeader index_header = make_header(sizeof(BlobLogFrame));
+	fwrite(&records_header, sizeof(records_header), 1, log.records);
+	fwrite(&index_header, sizeof(index_header), 1, log.index);
+	log.num_records = 0;
+	log.next_frame = -1;
+
+	//return OK code
+	return 1;
+}
+
+//adds the records of a blob list to the buffer of the frame
+static void add_records(std::vector<BlobRecord> &buffer, int frame, BLOB_TYPE type, const std::vector<cvBlob> &bloblist)
+{
+	for (size_t i = 0; i < bloblist.size(); i++)
+	{
+		const cvBlob &b = bloblist[i];
+		BlobRecord r;
+		r.frame = frame;
+		r.type = type;
+		r.ID = b.ID;
+		r.x = b.x; r.y = b.y; r.w = b.w; r.h = b.h;
+		r.label = b.label;
+		r.area = b.area;
+		r.cx = b.cx; r.cy = b.cy;
+		r.mu20 = b.mu20; r.mu02 = b.mu02; r.mu11 = b.mu11;
+		r.fill = b.fill;
+		r.reserved = 0;
+		buffer.push_back(r);
+	}
+}
+
+//writes the index entry of a frame with 'count' records starting at the current end of the log
+static void write_frame(BlobLogWriter &log, int frame, double timestamp, uint32_t count)
+{
+	BlobLogFrame entry;
+	entry.first_record = log.num_records;
+	entry.count = count;
+	entry.frame = frame;
+	entry.timestamp = timestamp;
+	fwrite(&entry, sizeof(entry), 1, log.index);
+}
+
+/**
+ *	Appends the foreground and STATIONARY blobs of a frame. Frame numbers must increase;
+ *	the numbers skipped since the previous call get empty index entries, so the index
+ *	stays dense and any frame is found by position.
+ *
+ * \param log Writer state
+ * \param frame Frame number
+ * \param timestamp Time of the frame (seconds since the epoch)
+ * \param blobs Foreground blobs
+ * \param sblobs STATIONARY blobs
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int appendBlobLog(BlobLogWriter &log, int frame, double timestamp, const std::vector<cvBlob> &blobs, const std::vector<cvBlob> &sblobs)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!log.records || !log.index || (log.next_frame >= 0 && frame < log.next_frame)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	if (log.next_frame < 0)
+		log.next_frame = frame;
+	for (; log.next_frame < frame; log.next_frame++)
+		write_frame(log, log.next_frame, 0, 0);
+
+	log.buffer.clear();
+	add_records(log.buffer, frame, BLOB_FG, blobs);
+	add_records(log.buffer, frame, BLOB_STATIONARY, sblobs);
+	if (!log.buffer.empty())
+		fwrite(log.buffer.data(), sizeof(BlobRecord), log.buffer.size(), log.records);
+	write_frame(log, frame, timestamp, (uint32_t)log.buffer.size());
+	log.num_records += log.buffer.size();
+	log.next_frame = frame + 1;
+
+	//return OK code
+	return 1;
+}
+
+void flushBlobLog(BlobLogWriter &log)
+{
+	if (log.records)
+		fflush(log.records);
+	if (log.index)
+		fflush(log.index);
+}
+
+void closeBlobLog(BlobLogWriter &log)
+{
+	flushBlobLog(log);
+	if (log.records)
+		fclose(log.records);
+	if (log.index)
+		fclose(log.index);
+	log.records = log.index = NULL;
+}
+
+BlobLogReader::BlobLogReader()
+	: records_map(NULL), index_map(NULL), records_bytes(0), index_bytes(0),
+	  records(NULL), frames(NULL), num_records(0), num_frames(0)
+{
+}
+
+BlobLogReader::~BlobLogReader()
+{
+	close();
+}
+
+//maps a whole file read-only (NULL if it cannot be opened or is empty)
+static void *map_file(const std::string &path, size_t &bytes)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	void *map = NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		bytes = (size_t)st.st_size;
+		map = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED)
+			map = NULL;
+	}
+	::close(fd); //the mapping stays valid
+	return map;
+}
+
+//true if the mapped file starts with a header of this format and 'record_size'
+static bool valid_header(const void *map, size_t bytes, uint32_t record_size)
+{
+	if (!map || bytes < sizeof(BlobLogHeader))
+		return false;
+	const BlobLogHeader *header = (const BlobLogHeader *)map;
+	return memcmp(header->magic, BLOBLOG_MAGIC, sizeof(BLOBLOG_MAGIC)) == 0 &&
+			header->version == BLOBLOG_VERSION && header->record_size == record_size;
+}
+
+/**
+ *	Maps both files of a log. Nothing is parsed: the records and the index are used in
+ *	place. Index entries pointing past the last complete record (a log cut while being
+ *	written) are ignored.
+ *
+ * \param path Record file of the log (the index is path + ".idx")
+ *
+ * \return true if the log could be mapped
+ */
+bool BlobLogReader::open(const std::string &path)
+{
+	close();
+	records_map = map_file(path, records_bytes);
+	index_map = map_file(path + ".idx", index_bytes);
+	if (!valid_header(records_map, records_bytes, sizeof(BlobRecord)) ||
+		!valid_header(index_map, index_bytes, sizeof(BlobLogFrame))){
+		std::cout << "Not a blob log: " << path << std::endl;
+		close();
+		return false;
+	}
+
+	records = (const BlobRecord *)((const char *)records_map + sizeof(BlobLogHeader));
+	frames = (const BlobLogFrame *)((const char *)index_map + sizeof(BlobLogHeader));
+	num_records = (records_bytes - sizeof(BlobLogHeader)) / sizeof(BlobRecord);
+	num_frames = (index_bytes - sizeof(BlobLogHeader)) / sizeof(BlobLogFrame);
+	while (num_frames > 0 && frames[num_frames-1].first_record + frames[num_frames-1].count > num_records)
+		num_frames--;
+	return true;
+}
+
+void BlobLogReader::close()
+{
+	if (records_map)
+		munmap(records_map, records_bytes);
+	if (index_map)
+		munmap(index_map, index_bytes);
+	records_map = index_map = NULL;
+	records_bytes = index_bytes = 0;
+	records = NULL;
+	frames = NULL;
+	num_records = num_frames = 0;
+}
+
+const BlobLogFrame *BlobLogReader::frame(int f) const
+{
+	if (!num_frames || f < frames[0].frame || f - frames[0].frame >= (int)num_frames)
+		return NULL;
+	return &frames[f - frames[0].frame];
+}
+
+/**
+ *	Records of a range of frames, which are contiguous in the log.
+ *
+ * \param first First frame of the range
+ * \param last Last frame of the range (included)
+ * \param count Number of records of the range
+ *
+ * \return First record of the range (NULL if the range has no frame in the log)
+ */
+const BlobRecord *BlobLogReader::range(int first, int last, size_t &count) const
+{
+	count = 0;
+	if (!num_frames)
+		return NULL;
+	first = std::max(first, firstFrame());
+	last = std::min(last, firstFrame() + (int)num_frames - 1);
+	if (first > last)
+		return NULL;
+
+	const BlobLogFrame *a = frame(first), *b = frame(last);
+	count = (size_t)(b->first_record + b->count - a->first_record);
+	return records + a->first_record;
+}
@@ -0,0 +1,130 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Binary blob log and memory-mapped reader
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class BlobLogReader
+ * \brief Memory-mapped reader of a blob log: any frame in O(1), frame ranges without parsing
+ *
+ * A blob log is a pair of append-only files with fixed-size little-endian records, each
+ * starting with a BlobLogHeader:
+ *
+ *	<path>        BlobRecord per blob, grouped by frame in increasing frame order
+ *	<path>.idx    BlobLogFrame per frame number from the first logged frame on (frames
+ *	              without blobs or not analyzed have count 0), so frame f is entry f - first
+ *
+ * Both files are only appended to, so a log cut by a crash is still readable up to the last
+ * frame entry whose records are complete. The records of consecutive frames are contiguous,
+ * so a range of frames is a single array of BlobRecord.
+ */
+
+#ifndef BLOBLOG_H_INCLUDE
+#define BLOBLOG_H_INCLUDE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "blobs.hpp"
+
+//"BLOBLOG" and format version of both files
+#define BLOBLOG_MAGIC "BLOBLOG"
+#define BLOBLOG_VERSION 1
+
+/// Header of both files of a log
+struct BlobLogHeader {
+	char     magic[8];     /* BLOBLOG_MAGIC (with its '\0')          */
+	uint32_t version;      /* BLOBLOG_VERSION                        */
+	uint32_t record_size;  /* sizeof(BlobRecord) or sizeof(BlobLogFrame) */
+};
+
+/// Type of a logged blob
+typedef enum {
+	BLOB_FG=0,
+	BLOB_STATIONARY=1
+} BLOB_TYPE;
+
+/// One blob of the log (64 bytes)
+struct BlobRecord {
+	int32_t frame;
+	int32_t type;               /* BLOB_TYPE                         */
+	int32_t ID;                 /* track ID                          */
+	int32_t x, y, w, h;
+	int32_t label;              /* CLASS                             */
+	int32_t area;
+	float   cx, cy;
+	float   mu20, mu02, mu11;
+	float   fill;
+	int32_t reserved;
+};
+
+/// Index entry of one frame (24 bytes)
+struct BlobLogFrame {
+	uint64_t first_record;      /* position of its first BlobRecord  */
+	uint32_t count;             /* number of BlobRecord of the frame */
+	int32_t  frame;
+	double   timestamp;         /* seconds since the epoch (0: not analyzed) */
+};
+
+/// Appends frames to a blob log
+struct BlobLogWriter {
+	FILE *records;
+	FILE *index;
+	uint64_t num_records;       /* records written                   */
+	int next_frame;             /* next frame number of the index (-1: none yet) */
+	std::vector<BlobRecord> buffer; /* records of the frame being appended */
+	BlobLogWriter() : records(NULL), index(NULL), num_records(0), next_frame(-1) {}
+};
+
+class BlobLogReader
+{
+public:
+	BlobLogReader();
+	~BlobLogReader();
+
+	//maps both files of the log. Returns false if they cannot be read or are not a blob log
+	bool open(const std::string &path);
+	void close();
+
+	int firstFrame() const { return num_frames ? frames[0].frame : 0; }
+	int numFrames() const { return (int)num_frames; }
+	size_t numRecords() const { return num_records; }
+
+	//index entry of frame 'f' (NULL if not in the log)
+	const BlobLogFrame *frame(int f) const;
+
+	//records of frames first..last (clamped to the log): pointer to the first one and count
+	const BlobRecord *range(int first, int last, size_t &count) const;
+
+private:
+	void *records_map, *index_map;
+	size_t records_bytes, index_bytes;
+	const BlobRecord *records;
+	const BlobLogFrame *frames;
+	size_t num_records, num_frames;
+};
+
+/*
+* Headers of blob log functions
+*
+*/
+
+//creates (or truncates) a log. Returns -1 if the files cannot be created
+int openBlobLog(const std::string &path, BlobLogWriter &log);
+
+//appends the blobs of frame 'frame' (frames must increase; skipped frame numbers get empty entries)
+int appendBlobLog(BlobLogWriter &log, int frame, double timestamp, const std::vector<cvBlob> &blobs, const std::vector<cvBlob> &sblobs);
+
+//flushes the records and then the index (so the index never points past the records)
+void flushBlobLog(BlobLogWriter &log);
+
+void closeBlobLog(BlobLogWriter &log);
+
+#endif
@@ -8,75 +8,187 @@
  */
 
 #include "blobs.hpp"
+#include "classifier.hpp"
 #include <opencv2/opencv.hpp>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /**
- *	Draws blobs with different rectangles on the image 'frame'. All the input arguments must be
- *  initialized when using this function.
+ *	Draws the boxes (and labels) of the blobs on 'canvas', which is modified in place.
  *
- * \param frame Input image
- * \param pBlobList List to store the blobs found
+ * \param canvas Image to draw on
+ * \param bloblist List of blobs to draw
  * \param labelled - true write label and color bb, false does not wirite label nor color bb
- *
- * \return Image containing the draw blobs. If no blobs have to be painted
- *  or arguments are wrong, the function returns a copy of the original "frame".
- *
  */
- Mat paintBlobImage(cv::Mat frame, std::vector<cvBlob> bloblist, bool labelled)
+void drawBlobs(cv::Mat &canvas, const std::vector<cvBlob> &bloblist, bool labelled)
 {
-	cv::Mat blobImage;
-	//check input conditions and return original if any is not satisfied
-	//...
-	frame.copyTo(blobImage);
-
-	//required variables to paint
-	//...
-
 	//paint each blob of the list
-	for(int i = 0; i < bloblist.size(); i++)
+	for(size_t i = 0; i < bloblist.size(); i++)
 	{
-		cvBlob blob = bloblist[i]; //get ith blob
-		//...
+		const cvBlob &blob = bloblist[i]; //get ith blob
+		Point p1 = Point(blob.x, blob.y);
+		Point p2 = Point(blob.x+blob.w, blob.y+blob.h);
+
+		if (!labelled)
+		{
+			rectangle(canvas, p1, p2, Scalar(255, 255, 255), 1, 8, 0);
+			continue;
+		}
+
 		Scalar color;
-		std::string label="";
+		const char *label;
 		switch(blob.label){
 		case PERSON:
 			color = Scalar(255,0,0);
 			label="PERSON";
 			break;
 		case CAR:
-					color = Scalar(0,255,0);
-					label="CAR";
-					break;
+			color = Scalar(0,255,0);
+			label="CAR";
+			break;
 		case OBJECT:
-					color = Scalar(0,0,255);
-					label="OBJECT";
-					break;
+			color = Scalar(0,0,255);
+			label="OBJECT";
+			break;
 		default:
 			color = Scalar(255, 255, 255);
 			label="UNKOWN";
 		}
+		rectangle(canvas, p1, p2, color, 1, 8, 0);
+		putText(canvas, std::string(label) + " " + std::to_string(blob.ID), p1, FONT_HERSHEY_SIMPLEX, 0.5, color);
+	}
+}
 
-		Point p1 = Point(blob.x, blob.y);
-		Point p2 = Point(blob.x+blob.w, blob.y+blob.h);
+/**
+ *	Sets the features of a blob from the raw moments of its pixels, as accumulated by the
+ *	labeling backends: m00 = pixel count, m10/m01 = sum of x/y, m20/m02/m11 = sum of
+ *	x*x / y*y / x*y (x is the column). The bounding box (x,y,w,h) must already be set.
+ *
+ * \param blob Blob to update (area, cx, cy, mu20, mu02, mu11, fill)
+ */
+void setBlobMoments(cvBlob &blob, double m00, double m10, double m01, double m20, double m02, double m11)
+{
+	blob.area = (int)m00;
+	if (m00 <= 0)
+	{
+		blob.cx = blob.cy = blob.mu20 = blob.mu02 = blob.mu11 = blob.fill = 0;
+		return;
+	}
+	double cx = m10/m00, cy = m01/m00;
+	blob.cx = (float)cx;
+	blob.cy = (float)cy;
+	blob.mu20 = (float)(m20/m00 - cx*cx);
+	blob.mu02 = (float)(m02/m00 - cy*cy);
+	blob.mu11 = (float)(m11/m00 - cx*cy);
+	//w and h are max-min differences, the box covers (w+1)x(h+1) pixels
+	blob.fill = (float)(m00 / ((blob.w+1.0)*(blob.h+1.0)));
+}
 
-		rectangle(blobImage, p1, p2, color, 1, 8, 0);
-		if (labelled)
-			{
-			rectangle(blobImage, p1, p2, color, 1, 8, 0);
-			putText(blobImage, label, p1, FONT_HERSHEY_SIMPLEX, 0.5, color);
-			}
-			else
-				rectangle(blobImage, p1, p2, Scalar(255, 255, 255), 1, 8, 0);
+/**
+ *	Maps blobs found in a mask downscaled by 'scale' to full resolution coordinates. Every
+ *	pixel of the small mask stands for a scale x scale block, so the box covers whole blocks
+ *	and the centroid moves to the block centre. Area and central moments scale by scale^2
+ *	(the spread inside each block is not added); the fill ratio does not change.
+ *
+ * \param bloblist List of blobs (updated)
+ * \param scale Downscale factor of the mask the blobs were found in
+ */
+void scaleBlobs(std::vector<cvBlob> &bloblist, int scale)
+{
+	if (scale <= 1)
+		return;
+
+	float offset = (scale - 1) * 0.5f;
+	float scale2 = (float)(scale * scale);
+	for (size_t i = 0; i < bloblist.size(); i++)
+	{
+		cvBlob &blob = bloblist[i];
+		blob.x *= scale;
+		blob.y *= scale;
+		blob.w = (blob.w + 1) * scale - 1;
+		blob.h = (blob.h + 1) * scale - 1;
+		blob.area *= scale * scale;
+		blob.cx = blob.cx * scale + offset;
+		blob.cy = blob.cy * scale + offset;
+		blob.mu20 *= scale2;
+		blob.mu02 *= scale2;
+		blob.mu11 *= scale2;
 	}
+}
 
-	//destroy all resources (if required)
-	//...
+/**
+ *	Fills a structure-of-arrays blob list from a list of blobs.
+ *
+ * \param bloblist Input blobs
+ * \param soa Output list, one array per field
+ */
+void toBlobList(const std::vector<cvBlob> &bloblist, BlobList &soa)
+{
+	soa.clear();
+	soa.reserve(bloblist.size());
+	for(size_t i = 0; i < bloblist.size(); i++)
+		soa.push_back(bloblist[i]);
+}
+
+/**
+ *	Fills a list of blobs from a structure-of-arrays blob list.
+ *
+ * \param soa Input list, one array per field
+ * \param bloblist Output blobs
+ */
+void fromBlobList(const BlobList &soa, std::vector<cvBlob> &bloblist)
+{
+	bloblist.resize(soa.size());
+	for(size_t i = 0; i < soa.size(); i++)
+		bloblist[i] = soa.get(i);
+}
+
+/**
+ *	Draws blobs with different rectangles on the image 'frame'. All the input arguments must be
+ *  initialized when using this function.
+ *
+ * \param frame Input image
+ * \param pBlobList List to store the blobs found
+ * \param labelled - true write label and color bb, false does not wirite label nor color bb
+ *
+ * \return Image containing the draw blobs. If no blobs have to be painted
+ *  or arguments are wrong, the function returns a copy of the original "frame".
+ *
+ */
+ Mat paintBlobImage(const cv::Mat &frame, const std::vector<cvBlob> &bloblist, bool labelled)
+{
+	cv::Mat blobImage;
+	frame.copyTo(blobImage);
+	drawBlobs(blobImage, bloblist, labelled);
 
 	//return the image to show
 	return blobImage;
 }
 
+/**
+ *	Renders the three blob overlays shown every frame (unlabelled blobs, labelled blobs and
+ *	labelled STATIONARY blobs) into the canvases of 'overlays'. The canvases are allocated on
+ *	the first frame and reused afterwards, so each frame costs one frame copy per layer plus
+ *	the boxes, with no allocation nor copy of the blob lists.
+ *
+ * \param frame Input image
+ * \param bloblist Filtered and classified blobs
+ * \param sbloblist Filtered and classified STATIONARY blobs
+ * \param overlays Reusable canvases, updated in place
+ */
+void renderBlobOverlays(const cv::Mat &frame, const std::vector<cvBlob> &bloblist, const std::vector<cvBlob> &sbloblist, BlobOverlays &overlays)
+{
+	//copyTo only reallocates when the frame size or type changes
+	frame.copyTo(overlays.unlabelled);
+	frame.copyTo(overlays.labelled);
+	frame.copyTo(overlays.stationary);
+
+	drawBlobs(overlays.unlabelled, bloblist, false);
+	drawBlobs(overlays.labelled, bloblist, true);
+	drawBlobs(overlays.stationary, sbloblist, true);
+}
+
 
 /**
  *	Blob extraction from 1-channel image (binary). The extraction is performed based
@@ -85,15 +197,60 @@
  *
  * \param fgmask Foreground/Background segmentation mask (1-channel binary image) 
  * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ * \param method Labeling backend (see LABELING typedef)
  *
  * \return Operation code (negative if not succesfull operation) 
  */
 
- //GLOBAL VAR
-PIXEL pixel_fg;
-std::vector<PIXEL> pixel_list;
+int extractBlobs(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity, LABELING method)
+{
+	const LabelingBackend *backend = findLabelingBackend(method);
+	if (!backend){
+		std::cout<<"Unknown labeling method" << std::endl;
+		return -1;
+	}
+	return backend->extract(fgmask, bloblist, connectivity);
+}
+
+//labeling backends, in LABELING order. New backends are added here
+static const LabelingBackend LABELING_BACKENDS[] = {
+	{ GRASSFIRE, "grassfire", extractBlobsGrassFire },
+	{ UNIONFIND, "unionfind", extractBlobsUnionFind },
+	{ RUNLENGTH, "runlength", extractBlobsRunLength },
+	{ UNIONFIND_PARALLEL, "unionfind_parallel", extractBlobsParallel },
+	{ FLOODFILL, "floodfill", extractBlobsFloodFill },
+	{ CCSTATS, "ccstats", extractBlobsCCStats },
+	{ GRASSFIRE, NULL, NULL }
+};
+
+const LabelingBackend *labelingBackends()
+{
+	return LABELING_BACKENDS;
+}
+
+const LabelingBackend *findLabelingBackend(const std::string &name)
+{
+	for (const LabelingBackend *b = LABELING_BACKENDS; b->name; b++)
+		if (name == b->name)
+			return b;
+	return NULL;
+}
+
+const LabelingBackend *findLabelingBackend(LABELING method)
+{
+	for (const LabelingBackend *b = LABELING_BACKENDS; b->name; b++)
+		if (b->method == method)
+			return b;
+	return NULL;
+}
 
-int extractBlobs(cv::Mat fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+/**
+ *	Grass-fire blob extraction: every foreground pixel of a blob is pushed to and popped
+ *	from 'pixel_list' (see check_nghb_pixel). Kept as the reference implementation.
+ *	The pixel stack is local to each call, so several threads can label at the same time.
+ */
+int extractBlobsGrassFire(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
 {	
 	//check input conditions and return -1 if any is not satisfied
 	//...		
@@ -108,6 +265,10 @@ int extractBlobs(cv::Mat fgmask, std::vector<cvBlob> &bloblist, int connectivity
 
 			    int counter = 0;
 
+				//stack of pixels to visit (see check_nghb_pixel)
+				PIXEL pixel_fg;
+				std::vector<PIXEL> pixel_list;
+
 				Mat aux; // image to be updated each time a blob is detected (blob cleared)
 
 				//clear blob list (to fill with this function)
@@ -132,7 +293,7 @@ int extractBlobs(cv::Mat fgmask, std::vector<cvBlob> &bloblist, int connectivity
 
 								pixel_list.push_back(pixel_fg);
 
-								cvBlob new_blob = check_nghb_pixel(connectivity, temp_fgmask);
+								cvBlob new_blob = check_nghb_pixel(connectivity, temp_fgmask, pixel_list);
 								counter ++;
 								new_blob.ID = counter;
 								bloblist.push_back(new_blob);
@@ -156,7 +317,7 @@ int extractBlobs(cv::Mat fgmask, std::vector<cvBlob> &bloblist, int connectivity
 }
 
 
-int removeSmallBlobs(std::vector<cvBlob> bloblist_in, std::vector<cvBlob> &bloblist_out, int min_width, int min_height)
+int removeSmallBlobs(const std::vector<cvBlob> &bloblist_in, std::vector<cvBlob> &bloblist_out, int min_width, int min_height)
 {
 	//check input conditions and return -1 if any is not satisfied
 
@@ -167,9 +328,9 @@ int removeSmallBlobs(std::vector<cvBlob> bloblist_in, std::vector<cvBlob> &blobl
 	bloblist_out.clear();
 
 
-	for(int i = 0; i < bloblist_in.size(); i++)
+	for(size_t i = 0; i < bloblist_in.size(); i++)
 	{
-		cvBlob blob_in = bloblist_in[i]; //get ith blob
+		const cvBlob &blob_in = bloblist_in[i]; //get ith blob
 		if(blob_in.w>=min_width && blob_in.h>=min_height){
 		bloblist_out.push_back(blob_in);
 				}
@@ -198,61 +359,12 @@ int removeSmallBlobs(std::vector<cvBlob> bloblist_in, std::vector<cvBlob> &blobl
   * \return Operation code (negative if not succesfull operation)
   */
 
- // ASPECT RATIO MODELS
-#define MEAN_PERSON 0.3950
-#define STD_PERSON 0.1887
-
-#define MEAN_CAR 1.4736
-#define STD_CAR 0.2329
-
-#define MEAN_OBJECT 1.2111
-#define STD_OBJECT 0.4470
-
-// end ASPECT RATIO MODELS
-
-// distances
-float ED(float val1, float val2)
-{
-	return sqrt(pow(val1-val2,2));
-}
-
-float WED(float val1, float val2, float std)
-{
-	return sqrt(pow(val1-val2,2)/pow(std,2));
-}
-//end distances
-
  int classifyBlobs(std::vector<cvBlob> &bloblist)
  {
- 	//required variables for classification
-    float weight, height;
-    float AR;
-    float person, car, object;
-
-    //classify each blob of the list
- 	for(int i = 0; i < bloblist.size(); i++)
- 	{
- 		weight = bloblist[i].w;
- 		height = bloblist[i].h;
- 		AR = weight/height; //aspect ratio
-
- 		person =  WED(AR, MEAN_PERSON, STD_PERSON);
- 		car = WED(AR, MEAN_CAR, STD_CAR);
- 		object = WED(AR, MEAN_OBJECT, STD_OBJECT);
-
- 			if(person<car && person<=object){
- 				bloblist[i].label = (PERSON);
- 			}else if(car<person && car<=object){
- 				bloblist[i].label = (CAR);
- 			}else if(object<person && object<car){
- 				bloblist[i].label = (OBJECT);
- 			}else{
- 				bloblist[i].label = (GROUP);
- 			}
- 			//std::cout<<bloblist[i].label << std::endl;
- 	}
-
-  	return 1;
+	//built-in aspect ratio models (see classifier.hpp), scored for the whole list at once
+	BlobList soa;
+	BlobFeatures features;
+	return classifyBlobs(NULL, bloblist, soa, features);
  }
 
 //stationary blob extraction function
@@ -260,11 +372,19 @@ float WED(float val1, float val2, float std)
   *	Stationary FG detection
   *
   * \param fgmask Foreground/Background segmentation mask (1-channel binary image)
-  * \param fgmask_history Foreground history counter image (1-channel integer image)
+  * \param fgmask_history Foreground history counter image (1-channel CV_16U image, updated in place)
   * \param sfgmask Foreground/Background segmentation mask (1-channel binary image)
+  * \param dirty_bands Optional output, one flag per band of DIRTY_BAND_ROWS rows: 1 if sfgmask
+  *  changed in the band since the previous call
+  * \param frames_elapsed Frames since the previous call (more than 1 if frames were skipped)
+  * \param params Frame rate, costs and threshold (NULL: the #defines below, see defaultStationaryParams)
   *
   * \return Operation code (negative if not succesfull operation)
   *
+  * The history update (equations 2 and 3), the normalization and the threshold (equation 9)
+  * are fused in one integer pass, vectorized with SSE2 and split in row stripes across
+  * threads. The history saturates at HISTORY_MAX instead of growing without limit.
+  *
   *
   * Based on: Stationary foreground detection for video-surveillance based on foreground and motion history images, D.Ortego, J.C.SanMiguel, AVSS2013
   *
@@ -277,56 +397,137 @@ float WED(float val1, float val2, float std)
 #define D_COST 5 // to set // decrement cost for stationarity detection wfneg
 #define STAT_TH 0.5// to set between 0.45 and .55
 
- int extractStationaryFG (Mat fgmask, Mat &fgmask_history, Mat &sfgmask)
- {
-
-	 //value used for further thresholding on equation 9
-	 float numframes4static=(FPS*SECS_STATIONARY);
-
-	 //Create a copy of fgmask not to modify its values
-	 cv::Mat fgmask1 = fgmask.clone();
-
-	 //easier to operate on floats
-	 fgmask1.convertTo(fgmask1, CV_32F);
-	 fgmask_history.convertTo(fgmask_history, CV_32F);
-
-	 //getting rid of shadows when pixel values =127
- 	 threshold(fgmask1,fgmask1,200,1,THRESH_BINARY);
-
- 	 //creating the NOTForeground or Background mask
-	 cv::Mat bgmask = Mat::ones(Size(fgmask1.cols,fgmask1.rows), CV_32F);
-	 bgmask= bgmask - fgmask1;
+ //history is stored as saturating uint16 (see extractStationaryFG)
+#define HISTORY_MAX 65535
 
-	 //increase or decrease the history according to equations 2 and 3
-	 fgmask_history = fgmask_history + (I_COST * fgmask1);
-     fgmask_history = fgmask_history - (D_COST * bgmask);
+ //stationary FG for the rows of a stripe: update the history in place and write sfgmask.
+ //Returns true if any pixel of the stripe changed its stationary state
+ static bool stationaryRows(const Mat &fgmask, Mat &fgmask_history, Mat &sfgmask, int h_th, int i_cost, int d_cost, int row_start, int row_end)
+ {
+	 bool changed = false;
+#if defined(__SSE2__)
+	 __m128i changed_acc = _mm_setzero_si128();
+#endif
+	 for (int y = row_start; y < row_end; y++)
+	 {
+		 const uchar *fg = fgmask.ptr<uchar>(y);
+		 ushort *hist = fgmask_history.ptr<ushort>(y);
+		 uchar *sfg = sfgmask.ptr<uchar>(y);
+		 int x = 0;
+#if defined(__SSE2__)
+		 const __m128i fg_th = _mm_set1_epi8((char)201); //fg is >200 (shadows 127 are not fg)
+		 const __m128i inc = _mm_set1_epi16((short)i_cost);
+		 const __m128i dec = _mm_set1_epi16((short)d_cost);
+		 const __m128i stat_th = _mm_set1_epi16((short)(h_th-1));
+		 for (; x + 16 <= fgmask.cols; x += 16)
+		 {
+			 __m128i m = _mm_loadu_si128((const __m128i*)(fg+x));
+			 __m128i is_fg = _mm_cmpeq_epi8(_mm_max_epu8(m, fg_th), m);
+			 __m128i is_fg_lo = _mm_unpacklo_epi8(is_fg, is_fg);
+			 __m128i is_fg_hi = _mm_unpackhi_epi8(is_fg, is_fg);
+
+			 //equations 2 and 3 with saturation at 0 and HISTORY_MAX
+			 __m128i zero = _mm_setzero_si128();
+			 __m128i h_lo = _mm_loadu_si128((const __m128i*)(hist+x));
+			 __m128i h_hi = _mm_loadu_si128((const __m128i*)(hist+x+8));
+			 __m128i old_lo = _mm_cmpeq_epi16(_mm_subs_epu16(h_lo, stat_th), zero);
+			 __m128i old_hi = _mm_cmpeq_epi16(_mm_subs_epu16(h_hi, stat_th), zero);
+			 h_lo = _mm_or_si128(_mm_and_si128(is_fg_lo, _mm_adds_epu16(h_lo, inc)), _mm_andnot_si128(is_fg_lo, _mm_subs_epu16(h_lo, dec)));
+			 h_hi = _mm_or_si128(_mm_and_si128(is_fg_hi, _mm_adds_epu16(h_hi, inc)), _mm_andnot_si128(is_fg_hi, _mm_subs_epu16(h_hi, dec)));
+			 _mm_storeu_si128((__m128i*)(hist+x), h_lo);
+			 _mm_storeu_si128((__m128i*)(hist+x+8), h_hi);
+
+			 //h >= h_th (unsigned): h-(h_th-1) saturates to 0 otherwise
+			 __m128i s_lo = _mm_cmpeq_epi16(_mm_subs_epu16(h_lo, stat_th), zero);
+			 __m128i s_hi = _mm_cmpeq_epi16(_mm_subs_epu16(h_hi, stat_th), zero);
+			 changed_acc = _mm_or_si128(changed_acc, _mm_or_si128(_mm_xor_si128(s_lo, old_lo), _mm_xor_si128(s_hi, old_hi)));
+			 //s_* is 0xFFFF for non stationary pixels, pack to 255/0 and invert
+			 __m128i s = _mm_packs_epi16(s_lo, s_hi);
+			 _mm_storeu_si128((__m128i*)(sfg+x), _mm_xor_si128(s, _mm_set1_epi8((char)255)));
+		 }
+#endif
+		 for (; x < fgmask.cols; x++)
+		 {
+			 int h = hist[x];
+			 bool was_stationary = (h >= h_th);
+			 h = (fg[x] > 200) ? std::min(h + i_cost, HISTORY_MAX) : std::max(h - d_cost, 0);
+			 hist[x] = (ushort)h;
+			 sfg[x] = (h >= h_th) ? 255 : 0;
+			 changed |= (was_stationary != (h >= h_th));
+		 }
+	 }
+#if defined(__SSE2__)
+	 changed |= (_mm_movemask_epi8(changed_acc) != 0);
+#endif
+	 return changed;
+ }
 
-     //TO avoid negative values in fgmask_history
- 	 threshold(fgmask_history,fgmask_history,0,1024,THRESH_TOZERO);
+ StationaryParams defaultStationaryParams()
+ {
+	 StationaryParams p = { FPS, SECS_STATIONARY, I_COST, D_COST, STAT_TH };
+	 return p;
+ }
 
-     //update sfgmask
+ int extractStationaryFG (const Mat &fgmask, Mat &fgmask_history, Mat &sfgmask, std::vector<uchar> *dirty_bands, int frames_elapsed, const StationaryParams *params)
+ {
+	 //check input conditions and return -1 if any is not satisfied
+	 if (!fgmask.data || fgmask.type() != CV_8UC1 || frames_elapsed < 1)
+		 return -1;
 
-     	 //normalize
-     	 cv::Mat fg_history_norm;
-     	 fg_history_norm = min(1,fgmask_history/(numframes4static));
+	 StationaryParams p = params ? *params : defaultStationaryParams();
 
-     	 //threshold
-     	 threshold(fg_history_norm,sfgmask,STAT_TH,255,THRESH_BINARY);
+	 //skipped frames are assumed to have the foreground of this one: the history moves by
+	 //the costs of all the elapsed frames at once (saturated as each single step)
+	 int i_cost = std::min(p.i_cost * frames_elapsed, HISTORY_MAX);
+	 int d_cost = std::min(p.d_cost * frames_elapsed, HISTORY_MAX);
 
-     	 //blobs format
-    	 sfgmask.convertTo(sfgmask, CV_8UC1);
+	 //value used for further thresholding on equation 9
+	 float numframes4static = std::max(1.0f, p.fps*p.secs_stationary);
+
+	 //history counter as saturating uint16, (re)started at zero if it does not match fgmask
+	 bool reset = (fgmask_history.size() != fgmask.size() || fgmask_history.type() != CV_16UC1);
+	 if (reset)
+		 fgmask_history = Mat::zeros(fgmask.size(), CV_16UC1);
+	 sfgmask.create(fgmask.size(), CV_8UC1);
+
+	 //smallest history value for which min(1,history/numframes4static) > STAT_TH (equation 9),
+	 //evaluated in float as the normalized history was
+	 int h_th = std::max(0, (int)(p.stat_th*numframes4static) - 1);
+	 while (h_th <= HISTORY_MAX && !(std::min(1.0f, h_th/numframes4static) > p.stat_th))
+		 h_th++;
+	 //at least 1 (a negative threshold gives 0): a pixel never in the foreground is not
+	 //stationary, and stationaryRows compares against h_th-1 as unsigned
+	 h_th = std::max(1, h_th);
+
+	 //single pass over fgmask, history and sfgmask split in bands of DIRTY_BAND_ROWS rows,
+	 //each band processed (and its dirty flag written) by one thread
+	 int num_bands = (fgmask.rows + DIRTY_BAND_ROWS - 1) / DIRTY_BAND_ROWS;
+	 std::vector<uchar> changed(num_bands, 0);
+	 parallel_for_(Range(0, num_bands), [&](const Range &range){
+		 for (int b = range.start; b < range.end; b++)
+			 changed[b] = stationaryRows(fgmask, fgmask_history, sfgmask, h_th, i_cost, d_cost,
+					 b*DIRTY_BAND_ROWS, std::min(fgmask.rows, (b+1)*DIRTY_BAND_ROWS));
+	 });
+
+	 //after a reset the previous mask is unknown, every band is dirty
+	 if (dirty_bands)
+	 {
+		 dirty_bands->swap(changed);
+		 if (reset)
+			 dirty_bands->assign(num_bands, 1);
+	 }
 
  return 1;
  }
 
 
- PIXEL max_pix;
- PIXEL min_pix;
- cvBlob check_nghb_pixel(int connectivity, Mat temp_fgmask)
+ cvBlob check_nghb_pixel(int connectivity, Mat &temp_fgmask, std::vector<PIXEL> &pixel_list)
  {
 	 cvBlob blob={};
-	 max_pix = pixel_list.back();
-	 min_pix = pixel_list.back();
+	 PIXEL pixel_fg;
+	 PIXEL max_pix = pixel_list.back();
+	 PIXEL min_pix = pixel_list.back();
+	 double m00 = 0, m10 = 0, m01 = 0, m20 = 0, m02 = 0, m11 = 0; //raw moments (x is the column)
 
 	 while (!pixel_list.empty())
 	 	{
@@ -334,11 +535,24 @@ float WED(float val1, float val2, float std)
 		 pixel_fg = pixel_list.back(); // take the last element from the list
 		 int x_value = pixel_fg.pixel_x; //the initial position,x for grass-fire
 		 int y_value = pixel_fg.pixel_y; //the initial position,y for grass-fire
+
+		 //a pixel may be pushed by several neighbours, only the first visit counts
+		 if (temp_fgmask.at<uchar>(x_value,y_value) != 255)
+		 {
+			 pixel_list.pop_back();
+			 continue;
+		 }
+		 m00++;
+		 m10 += y_value;
+		 m01 += x_value;
+		 m20 += (double)y_value*y_value;
+		 m02 += (double)x_value*x_value;
+		 m11 += (double)x_value*y_value;
 		 temp_fgmask.at<uchar>(pixel_fg.pixel_x,pixel_fg.pixel_y) = 0; // set this pixel value to 0 in foreground
 		 pixel_list.pop_back(); //remove this element from the list (last one)
 
 		 //Dealing with pixel limits
-		 maxmin_coordinates();
+		 maxmin_coordinates(pixel_fg, max_pix, min_pix);
 
 
 
@@ -423,12 +637,13 @@ float WED(float val1, float val2, float std)
 	 	blob.y = (min_pix.pixel_x);
 	 	blob.h = (max_pix.pixel_x-min_pix.pixel_x); //height of the blob
 	 	blob.w = (max_pix.pixel_y-min_pix.pixel_y); //weight of the blob
+	 	setBlobMoments(blob, m00, m10, m01, m20, m02, m11);
 
 	 	return blob;
 
  }
 
- void maxmin_coordinates()
+ void maxmin_coordinates(const PIXEL &pixel_fg, PIXEL &max_pix, PIXEL &min_pix)
  {
 	 		 //for right limit
 	 	 	 if( pixel_fg.pixel_x > max_pix.pixel_x)
@@ -20,13 +20,11 @@
 
 #include <opencv2/opencv.hpp>
 #include <list>
+#include <string>
 
 using namespace cv; //avoid using 'cv' to declare OpenCV functions and variables (cv::Mat or Mat)
 
 
-// Maximun number of char in the blob's format
-const int MAX_FORMAT = 1024;
-
 /// Type of labels for blobs
 typedef enum {	
 	UNKNOWN=0, 
@@ -36,6 +34,16 @@ typedef enum {
 	OBJECT=4
 } CLASS;
 
+/// Connected component labeling backends for extractBlobs
+typedef enum {
+	GRASSFIRE=0,
+	UNIONFIND=1,
+	RUNLENGTH=2,
+	UNIONFIND_PARALLEL=3,
+	FLOODFILL=4,
+	CCSTATS=5
+} LABELING;
+
 
 typedef struct PIXEL
 {
@@ -48,38 +56,147 @@ struct cvBlob {
 	int   x, y;  /* blob position  */
 	int   w, h;  /* blob sizes     */	
 	CLASS label; /* type of blob   */
-	char format[MAX_FORMAT];
+	int   area;  /* pixel count    */
+	float cx, cy;            /* centroid                                    */
+	float mu20, mu02, mu11;  /* central second-order moments (over area)    */
+	float fill;              /* area / bounding box area                    */
+};
+
+/// Structure-of-arrays blob list: one contiguous array per field, for passes that
+/// process a whole list at once (e.g. scoring every blob of a frame)
+struct BlobList {
+	std::vector<int> ID;
+	std::vector<int> x, y;
+	std::vector<int> w, h;
+	std::vector<CLASS> label;
+	std::vector<int> area;
+	std::vector<float> cx, cy;
+	std::vector<float> mu20, mu02, mu11;
+	std::vector<float> fill;
+
+	size_t size() const { return ID.size(); }
+	void clear()
+	{
+		ID.clear(); x.clear(); y.clear(); w.clear(); h.clear(); label.clear();
+		area.clear(); cx.clear(); cy.clear(); mu20.clear(); mu02.clear(); mu11.clear(); fill.clear();
+	}
+	void reserve(size_t n)
+	{
+		ID.reserve(n); x.reserve(n); y.reserve(n); w.reserve(n); h.reserve(n); label.reserve(n);
+		area.reserve(n); cx.reserve(n); cy.reserve(n); mu20.reserve(n); mu02.reserve(n); mu11.reserve(n); fill.reserve(n);
+	}
+	void push_back(const cvBlob &B)
+	{
+		ID.push_back(B.ID); x.push_back(B.x); y.push_back(B.y);
+		w.push_back(B.w); h.push_back(B.h); label.push_back(B.label);
+		area.push_back(B.area); cx.push_back(B.cx); cy.push_back(B.cy);
+		mu20.push_back(B.mu20); mu02.push_back(B.mu02); mu11.push_back(B.mu11); fill.push_back(B.fill);
+	}
+	cvBlob get(size_t i) const
+	{
+		cvBlob B = { ID[i], x[i], y[i], w[i], h[i], label[i], area[i], cx[i], cy[i], mu20[i], mu02[i], mu11[i], fill[i] };
+		return B;
+	}
+};
+
+/// Parameters of extractStationaryFG (see defaultStationaryParams for the tuned values)
+struct StationaryParams {
+	float fps;               /* frame rate of the sequence                          */
+	float secs_stationary;   /* seconds of foreground to become fully stationary    */
+	int   i_cost;            /* history increment per foreground frame (wfpos)      */
+	int   d_cost;            /* history decrement per background frame (wfneg)      */
+	float stat_th;           /* threshold of the normalized history (equation 9)    */
+};
+
+// Rows per band tracked by extractStationaryFG to report where sfgmask changed
+const int DIRTY_BAND_ROWS = 16;
+
+/// Blobs of the last mask labeled by extractBlobsIncremental
+struct IncrementalBlobs {
+	std::vector<cvBlob> bloblist;  /* blobs of the last mask                 */
+	Size size;                     /* size of the last mask (0x0: no cache)  */
+	int connectivity;              /* connectivity used to label it          */
+	IncrementalBlobs() : connectivity(0) {}
+};
+
+/// Labeling backend selectable at runtime (see labelingBackends). Every backend returns
+/// the blobs of the whole mask in raster order of their first pixel, with w/h as max-min
+/// coordinate differences, so they can be swapped per stream
+struct LabelingBackend {
+	LABELING method;
+	const char *name;  /* name on the command line and in reports */
+	int (*extract)(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+};
+
+/// Reusable canvases with the blob overlays of a frame (see renderBlobOverlays)
+struct BlobOverlays {
+	Mat unlabelled;  /* blobs without label          */
+	Mat labelled;    /* blobs with label and color   */
+	Mat stationary;  /* STATIONARY blobs with label  */
 };
 
 inline cvBlob initBlob(int id, int x, int y, int w, int h)
 {
-	cvBlob B = { id,x,y,w,h,UNKNOWN};
+	cvBlob B = { id,x,y,w,h,UNKNOWN,0,0,0,0,0,0,0};
 	return B;
 }
 
+//sets area, centroid, central moments and fill ratio of a blob from its raw moments
+void setBlobMoments(cvBlob &blob, double m00, double m10, double m01, double m20, double m02, double m11);
+
 /*
 * Headers of blob-based functions
 *
 */
 
-// Grass-fire
-cvBlob check_nghb_pixel(int connectivity, Mat temp_fgmask);
+// Grass-fire: blob of the pixels reachable from the seed on top of 'pixel_list' (used as the stack)
+cvBlob check_nghb_pixel(int connectivity, Mat &temp_fgmask, std::vector<PIXEL> &pixel_list);
 
 //to find max and min coordinates to build the blob
-void maxmin_coordinates();
+void maxmin_coordinates(const PIXEL &pixel_fg, PIXEL &max_pix, PIXEL &min_pix);
 
 //blob drawing functions
-Mat paintBlobImage(Mat frame, std::vector<cvBlob> bloblist, bool labelled);
+Mat paintBlobImage(const Mat &frame, const std::vector<cvBlob> &bloblist, bool labelled);
+void drawBlobs(Mat &canvas, const std::vector<cvBlob> &bloblist, bool labelled);
+void renderBlobOverlays(const Mat &frame, const std::vector<cvBlob> &bloblist, const std::vector<cvBlob> &sbloblist, BlobOverlays &overlays);
+
+//conversion between blob lists and structure-of-arrays lists
+void toBlobList(const std::vector<cvBlob> &bloblist, BlobList &soa);
+void fromBlobList(const BlobList &soa, std::vector<cvBlob> &bloblist);
+
+//maps blobs found in a mask downscaled by 'scale' to full resolution coordinates
+void scaleBlobs(std::vector<cvBlob> &bloblist, int scale);
 
 //blob extraction functions
-int extractBlobs(Mat fgmask, std::vector<cvBlob> &bloblist, int connectivity);
-int removeSmallBlobs(std::vector<cvBlob> bloblist_in, std::vector<cvBlob> &bloblist_out, int min_width, int min_height);
+int extractBlobs(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity, LABELING method=UNIONFIND);
+int extractBlobsGrassFire(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+int extractBlobsUnionFind(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+int extractBlobsRunLength(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+int extractBlobsParallel(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+int extractBlobsFloodFill(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+int extractBlobsCCStats(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+
+//registered labeling backends (NULL-terminated) and lookup by name or method (NULL if unknown)
+const LabelingBackend *labelingBackends();
+const LabelingBackend *findLabelingBackend(const std::string &name);
+const LabelingBackend *findLabelingBackend(LABELING method);
+
+//floodFill helpers: bordered and inverted mask (fg 0, bg 255) and next 0 pixel in raster order
+void prepareFloodFillMask(const Mat &fgmask, Mat &temp_fgmask);
+bool findNextSeed(const Mat &temp_fgmask, int &x, int &y);
+int removeSmallBlobs(const std::vector<cvBlob> &bloblist_in, std::vector<cvBlob> &bloblist_out, int min_width, int min_height);
 
 //blob classification functions
 int classifyBlobs(std::vector<cvBlob> &bloblist);
 
 //stationary blob extraction functions
-int extractStationaryFG (Mat fgmask, Mat &fgmask_history, Mat &sfgmask);
+int extractStationaryFG (const Mat &fgmask, Mat &fgmask_history, Mat &sfgmask, std::vector<uchar> *dirty_bands=NULL, int frames_elapsed=1, const StationaryParams *params=NULL);
+
+//FPS, SECS_STATIONARY, I_COST, D_COST and STAT_TH (the parameters used when none are given)
+StationaryParams defaultStationaryParams();
+
+//incremental blob extraction for masks that change in few bands (e.g. sfgmask)
+int extractBlobsIncremental(const Mat &mask, const std::vector<uchar> &dirty_bands, int connectivity, IncrementalBlobs &cache, std::vector<cvBlob> &bloblist, LABELING method=UNIONFIND);
 
 #endif
 
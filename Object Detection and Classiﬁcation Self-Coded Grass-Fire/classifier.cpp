@@ -0,0 +1,190 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Batch blob classifier with loadable models
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "classifier.hpp"
+#include <fstream>
+#include <sstream>
+
+//class of a name in the model file (-1 if unknown)
+static int parse_class(const std::string &name)
+{
+	if (name == "PERSON") return PERSON;
+	if (name == "GROUP") return GROUP;
+	if (name == "CAR") return CAR;
+	if (name == "OBJECT") return OBJECT;
+	return -1;
+}
+
+//feature of a name in the model file (-1 if unknown)
+static int parse_feature(const std::string &name)
+{
+	if (name == "aspect_ratio") return FEATURE_ASPECT_RATIO;
+	if (name == "fill") return FEATURE_FILL;
+	return -1;
+}
+
+/**
+ *	Reads the class models of a file (see BlobClassifier). Lines that cannot be parsed are
+ *	reported and skipped; a class appearing in several lines gets all their features.
+ *
+ * \param path Model file
+ * \param classifier Loaded models
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int loadClassifier(const std::string &path, BlobClassifier &classifier)
+{
+	std::ifstream file(path.c_str());
+	if (!file.is_open()){
+		std::cout << "Could not open model file " << path << std::endl;
+		return -1;
+	}
+
+	classifier.models.clear();
+	std::string line;
+	for (int line_number = 1; std::getline(file, line); line_number++)
+	{
+		std::istringstream in(line);
+		std::string class_name, feature_name;
+		double mean, std;
+		if (!(in >> class_name) || class_name[0] == '#')
+			continue;
+
+		int label = parse_class(class_name);
+		int feature = (in >> feature_name) ? parse_feature(feature_name) : -1;
+		if (label < 0 || feature < 0 || !(in >> mean >> std) || std <= 0){
+			std::cout << path << ":" << line_number << ": invalid model line" << std::endl;
+			continue;
+		}
+
+		//model of the class, created on its first line
+		size_t k = 0;
+		while (k < classifier.models.size() && classifier.models[k].label != label)
+			k++;
+		if (k == classifier.models.size())
+		{
+			ClassModel model;
+			model.label = (CLASS)label;
+			for (int f = 0; f < NUM_FEATURES; f++)
+				model.mean[f] = model.inv_var[f] = 0;
+			classifier.models.push_back(model);
+		}
+		classifier.models[k].mean[feature] = (float)mean;
+		classifier.models[k].inv_var[feature] = (float)(1.0 / (std * std));
+	}
+
+	if (classifier.models.empty()){
+		std::cout << "No class models in " << path << std::endl;
+		return -1;
+	}
+
+	//return OK code
+	return 1;
+}
+
+void defaultClassifier(BlobClassifier &classifier)
+{
+	classifier.models.assign(DEFAULT_MODELS, DEFAULT_MODELS + NUM_DEFAULT_MODELS);
+}
+
+void computeFeatures(const BlobList &soa, BlobFeatures &features)
+{
+	size_t n = soa.size();
+	for (int f = 0; f < NUM_FEATURES; f++)
+		features.value[f].resize(n);
+
+	float *ar = features.value[FEATURE_ASPECT_RATIO].data();
+	float *fill = features.value[FEATURE_FILL].data();
+	for (size_t i = 0; i < n; i++)
+	{
+		ar[i] = (float)soa.w[i] / (float)soa.h[i];
+		fill[i] = soa.fill[i];
+	}
+}
+
+//pointers to the feature arrays, as taken by scoreBlobs
+static void feature_pointers(const BlobFeatures &features, const float *value[NUM_FEATURES])
+{
+	for (int f = 0; f < NUM_FEATURES; f++)
+		value[f] = features.value[f].data();
+}
+
+/**
+ *	Classifies all the blobs of a list in one pass: features are computed into contiguous
+ *	arrays and every blob is scored against all the models (see scoreBlobs).
+ *
+ * \param classifier Class models
+ * \param soa Blob list (label is updated)
+ * \param features Scratch buffers for the features (reused between calls)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int classifyBlobList(const BlobClassifier &classifier, BlobList &soa, BlobFeatures &features)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (classifier.models.empty()){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	int n = (int)soa.size();
+	computeFeatures(soa, features);
+	features.label.resize(n);
+
+	const float *value[NUM_FEATURES];
+	feature_pointers(features, value);
+	scoreBlobs<0>(classifier.models.data(), (int)classifier.models.size(), value, n, features.label.data());
+
+	for (int i = 0; i < n; i++)
+		soa.label[i] = (CLASS)features.label[i];
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Blob classification between the available classes in 'Blob.hpp' (see CLASS typedef) for
+ *	a list of cvBlob. Without a classifier the built-in models are used through the
+ *	compile-time specialization of scoreBlobs.
+ *
+ * \param classifier Class models (NULL: built-in models)
+ * \param bloblist List of blobs to classify
+ * \param soa Scratch structure-of-arrays copy of the list (reused between calls)
+ * \param features Scratch buffers for the features (reused between calls)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int classifyBlobs(const BlobClassifier *classifier, std::vector<cvBlob> &bloblist, BlobList &soa, BlobFeatures &features)
+{
+	toBlobList(bloblist, soa);
+
+	if (classifier)
+	{
+		if (classifyBlobList(*classifier, soa, features) < 0)
+			return -1;
+	}
+	else
+	{
+		int n = (int)soa.size();
+		computeFeatures(soa, features);
+		features.label.resize(n);
+
+		const float *value[NUM_FEATURES];
+		feature_pointers(features, value);
+		scoreBlobs<NUM_DEFAULT_MODELS>(DEFAULT_MODELS, NUM_DEFAULT_MODELS, value, n, features.label.data());
+		for (int i = 0; i < n; i++)
+			soa.label[i] = (CLASS)features.label[i];
+	}
+
+	for (size_t i = 0; i < bloblist.size(); i++)
+		bloblist[i].label = soa.label[i];
+
+	//return OK code
+	return 1;
+}
@@ -0,0 +1,192 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Batch blob classifier with loadable models
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class BlobClassifier
+ * \brief Gaussian feature models of the blob classes, scored over a whole blob list at once
+ *
+ * Every class is modelled by the mean and standard deviation of some blob features. A blob
+ * takes the class with the lowest weighted squared distance sum(((v - mean)/std)^2) over the
+ * features of the model (the square of the WED distance, so no sqrt/pow is needed) and
+ * GROUP when the lowest distance is shared by several classes.
+ *
+ * Models are read from a text file, one line per class and feature:
+ *
+ *	# class feature mean std
+ *	PERSON aspect_ratio 0.3950 0.1887
+ *
+ * with class PERSON, GROUP, CAR or OBJECT and feature aspect_ratio (w/h) or fill (area over
+ * bounding box area). Features not given for a class are not used for that class.
+ */
+
+#ifndef CLASSIFIER_H_INCLUDE
+#define CLASSIFIER_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <limits>
+
+#include "blobs.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ASPECT RATIO MODELS
+#define MEAN_PERSON 0.3950
+#define STD_PERSON 0.1887
+
+#define MEAN_CAR 1.4736
+#define STD_CAR 0.2329
+
+#define MEAN_OBJECT 1.2111
+#define STD_OBJECT 0.4470
+
+// end ASPECT RATIO MODELS
+
+/// Blob features used by the class models
+typedef enum {
+	FEATURE_ASPECT_RATIO=0,
+	FEATURE_FILL=1,
+	NUM_FEATURES
+} FEATURE;
+
+/// Gaussian model of one class
+struct ClassModel {
+	CLASS label;
+	float mean[NUM_FEATURES];
+	float inv_var[NUM_FEATURES];  /* 1/std^2, 0 if the feature is not used */
+};
+
+/// Models of all the classes
+struct BlobClassifier {
+	std::vector<ClassModel> models;
+};
+
+/// Features of a blob list, one contiguous array per feature
+struct BlobFeatures {
+	std::vector<float> value[NUM_FEATURES];
+	std::vector<int> label;
+};
+
+/// Built-in models (aspect ratio only), used when no model file is loaded
+static const int NUM_DEFAULT_MODELS = 3;
+static const ClassModel DEFAULT_MODELS[NUM_DEFAULT_MODELS] = {
+	{ PERSON, { (float)MEAN_PERSON, 0 }, { (float)(1.0/(STD_PERSON*STD_PERSON)), 0 } },
+	{ CAR,    { (float)MEAN_CAR,    0 }, { (float)(1.0/(STD_CAR*STD_CAR)),       0 } },
+	{ OBJECT, { (float)MEAN_OBJECT, 0 }, { (float)(1.0/(STD_OBJECT*STD_OBJECT)), 0 } }
+};
+
+/*
+* Headers of classifier functions
+*
+*/
+
+//reads the class models of a file. Returns -1 if the file cannot be read or has no valid model
+int loadClassifier(const std::string &path, BlobClassifier &classifier);
+
+//copies the built-in models
+void defaultClassifier(BlobClassifier &classifier);
+
+//computes the features of a blob list
+void computeFeatures(const BlobList &soa, BlobFeatures &features);
+
+//classifies a whole blob list with the models of 'classifier' (label of soa is updated)
+int classifyBlobList(const BlobClassifier &classifier, BlobList &soa, BlobFeatures &features);
+
+//same for a list of cvBlob, with the built-in models if 'classifier' is NULL ('soa' and
+//'features' are scratch buffers, reused between calls)
+int classifyBlobs(const BlobClassifier *classifier, std::vector<cvBlob> &bloblist, BlobList &soa, BlobFeatures &features);
+
+/**
+ *	Scores 'n' blobs against the models and writes the label of the closest one. Ties keep
+ *	the precedence of the aspect ratio rule: OBJECT loses its ties, a tie between other
+ *	classes (e.g. PERSON and CAR) is GROUP. Blobs are processed 4 at a time with SSE2, all
+ *	the models for each group of blobs.
+ *
+ *	With NUM_MODELS > 0 the number of models is a compile-time constant and the loops over
+ *	models and features are fully unrolled, so a fixed model table (e.g. a static const
+ *	array) is folded into the code. With NUM_MODELS = 0 'num_models' is used.
+ *
+ * \param models Class models
+ * \param num_models Number of models (only used if NUM_MODELS is 0)
+ * \param value Arrays of the blob features (indexed by FEATURE)
+ * \param n Number of blobs
+ * \param label Output label of each blob
+ */
+template<int NUM_MODELS>
+inline void scoreBlobs(const ClassModel *models, int num_models, const float *const *value, int n, int *label)
+{
+	const int num = (NUM_MODELS > 0) ? NUM_MODELS : num_models;
+	const float inf = std::numeric_limits<float>::infinity();
+	int i = 0;
+
+#if defined(__SSE2__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 best = _mm_set1_ps(inf);
+		__m128i lab = _mm_set1_epi32(GROUP);
+		for (int k = 0; k < num; k++)
+		{
+			const ClassModel &m = models[k];
+			__m128 d = _mm_setzero_ps();
+			for (int f = 0; f < NUM_FEATURES; f++)
+			{
+				if (m.inv_var[f] == 0)
+					continue;
+				__m128 diff = _mm_sub_ps(_mm_loadu_ps(value[f] + i), _mm_set1_ps(m.mean[f]));
+				d = _mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(m.inv_var[f])));
+			}
+			//a lower distance takes the blob; on an equal one OBJECT loses and other classes tie (GROUP)
+			__m128i lt = _mm_castps_si128(_mm_cmplt_ps(d, best));
+			if (m.label != OBJECT)
+			{
+				__m128i eq = _mm_castps_si128(_mm_cmpeq_ps(d, best));
+				__m128i was_object = _mm_cmpeq_epi32(lab, _mm_set1_epi32(OBJECT));
+				__m128i tie = _mm_or_si128(_mm_and_si128(was_object, _mm_set1_epi32(m.label)), _mm_andnot_si128(was_object, _mm_set1_epi32(GROUP)));
+				lab = _mm_or_si128(_mm_and_si128(eq, tie), _mm_andnot_si128(eq, lab));
+			}
+			lab = _mm_or_si128(_mm_and_si128(lt, _mm_set1_epi32(m.label)), _mm_andnot_si128(lt, lab));
+			best = _mm_min_ps(d, best); //NaN distances keep the best so far
+		}
+		_mm_storeu_si128((__m128i*)(label + i), lab);
+	}
+#endif
+
+	//remaining blobs (or all of them without SSE2)
+	for (; i < n; i++)
+	{
+		float best = inf;
+		int lab = GROUP;
+		for (int k = 0; k < num; k++)
+		{
+			const ClassModel &m = models[k];
+			float d = 0;
+			for (int f = 0; f < NUM_FEATURES; f++)
+			{
+				if (m.inv_var[f] == 0)
+					continue;
+				float diff = value[f][i] - m.mean[f];
+				d += diff * diff * m.inv_var[f];
+			}
+			if (d < best)
+			{
+				best = d;
+				lab = m.label;
+			}
+			else if (d == best && m.label != OBJECT)
+				lab = (lab == OBJECT) ? m.label : GROUP;
+		}
+		label[i] = lab;
+	}
+}
+
+#endif
@@ -0,0 +1,258 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Differential equivalence and performance harness of the labeling implementations
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+//system libraries C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//opencv libraries
+#include <opencv2/opencv.hpp>
+
+//include for blob-related functions
+#include "blobs.hpp"
+
+//include for the synthetic masks
+#include "synthetic.hpp"
+
+//namespaces
+using namespace cv;
+using namespace std;
+
+/**
+ *	extractBlobs of the former "Grass-Fire using FloodFill" tree: the mask is bordered and
+ *	inverted (255 -> 0, anything else -> 255) and every 0 pixel found in raster order is
+ *	filled with cv::floodFill. Width and height are those of the floodFill Rect (number of
+ *	columns and rows), not max-min as in this tree. Area and moments are not computed.
+ */
+static int extractBlobsFloodFillTree(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	Mat temp_fgmask;
+	copyMakeBorder(fgmask, temp_fgmask, 1, 1, 1, 1, BORDER_CONSTANT, 0);
+	for (int y = 0; y < temp_fgmask.rows; y++)
+	{
+		uchar *row = temp_fgmask.ptr<uchar>(y);
+		for (int x = 0; x < temp_fgmask.cols; x++)
+			row[x] = (row[x] == 255) ? 0 : 255;
+	}
+
+	bloblist.clear();
+	for (int y = 1; y <= fgmask.rows; y++)
+		for (int x = 1; x <= fgmask.cols; x++)
+			if (temp_fgmask.at<uchar>(y, x) == 0)
+			{
+				Rect rect;
+				floodFill(temp_fgmask, Point(x, y), 255, &rect, 0, 0, connectivity);
+				bloblist.push_back(initBlob((int)bloblist.size(), rect.x - 1, rect.y - 1, rect.width, rect.height));
+			}
+	return 1;
+}
+
+typedef int (*LabelingFn)(const Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity);
+
+/// Labeling implementation under test
+struct Backend {
+	const char *name;
+	LabelingFn fn;
+	bool exact;        /* expected to match the reference blob for blob (failures set the exit code) */
+	bool has_area;     /* computes area (compared with the reference)                                */
+};
+
+/// Differences of a backend against the reference, accumulated over all the masks
+struct DiffStats {
+	int masks, identical_masks;
+	long blobs, matched;
+	long size_off_by_one;   /* same corner, w and h one larger (floodFill Rect convention) */
+	long box_mismatch;      /* same corner, other box size or area                          */
+	long missing, missing_border; /* reference blobs not found (touching row or column 0)    */
+	long extra;             /* blobs not in the reference                                   */
+	double seconds;
+	long pixels;
+};
+
+//blobs ordered by top-left corner and size
+static bool box_before(const cvBlob &a, const cvBlob &b)
+{
+	if (a.y != b.y) return a.y < b.y;
+	if (a.x != b.x) return a.x < b.x;
+	if (a.w != b.w) return a.w < b.w;
+	return a.h < b.h;
+}
+
+/**
+ *	Compares the blob set of a backend with the reference one (as sets: order and IDs are
+ *	not compared). Blobs are paired by top-left corner; a pair is a match if w, h (and area
+ *	when the backend has it) are equal and an off-by-one if w and h are one larger.
+ *
+ * \return true if both sets are identical
+ */
+static bool compareBlobs(const std::vector<cvBlob> &reference, const std::vector<cvBlob> &blobs, bool has_area, DiffStats &diff)
+{
+	std::vector<cvBlob> ref = reference, out = blobs;
+	std::sort(ref.begin(), ref.end(), box_before);
+	std::sort(out.begin(), out.end(), box_before);
+
+	bool identical = true;
+	std::vector<uchar> used(out.size(), 0);
+	size_t j0 = 0;
+	for (size_t i = 0; i < ref.size(); i++)
+	{
+		const cvBlob &r = ref[i];
+		while (j0 < out.size() && (out[j0].y < r.y || (out[j0].y == r.y && out[j0].x < r.x)))
+			j0++;
+
+		//best unused candidate with the same corner
+		int best = -1, kind = 3; //0 match, 1 off-by-one, 2 other size
+		for (size_t j = j0; j < out.size() && out[j].y == r.y && out[j].x == r.x; j++)
+		{
+			if (used[j])
+				continue;
+			const cvBlob &b = out[j];
+			int k = (b.w == r.w && b.h == r.h && (!has_area || b.area == r.area)) ? 0 :
+					(b.w == r.w + 1 && b.h == r.h + 1) ? 1 : 2;
+			if (k < kind)
+			{
+				kind = k;
+				best = (int)j;
+			}
+		}
+
+		if (best < 0)
+		{
+			diff.missing++;
+			if (r.x == 0 || r.y == 0)
+				diff.missing_border++;
+			identical = false;
+			continue;
+		}
+		used[best] = 1;
+		if (kind == 0)
+			diff.matched++;
+		else
+		{
+			identical = false;
+			if (kind == 1)
+				diff.size_off_by_one++;
+			else
+				diff.box_mismatch++;
+		}
+	}
+	for (size_t j = 0; j < out.size(); j++)
+		if (!used[j])
+		{
+			diff.extra++;
+			identical = false;
+		}
+	diff.blobs += (long)ref.size();
+	return identical;
+}
+
+//runs every backend on a mask and accumulates its differences and time
+static void checkMask(const Mat &fgmask, int connectivity, const std::vector<Backend> &backends, std::vector<DiffStats> &diffs, int reps)
+{
+	std::vector<cvBlob> reference, blobs;
+	extractBlobsUnionFind(fgmask, reference, connectivity);
+
+	for (size_t b = 0; b < backends.size(); b++)
+	{
+		int64 t = getTickCount();
+		for (int r = 0; r < reps; r++)
+			backends[b].fn(fgmask, blobs, connectivity);
+		diffs[b].seconds += (getTickCount() - t) / getTickFrequency() / reps;
+		diffs[b].pixels += (long)fgmask.total();
+
+		diffs[b].masks++;
+		if (compareBlobs(reference, blobs, backends[b].has_area, diffs[b]))
+			diffs[b].identical_masks++;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	//command line options
+	//	--reps <n>        timed repetitions per mask (default 3)
+	//	<mask> ...        mask images to check (1-channel, 255 fg, 127 shadow); without them a
+	//	                  set of synthetic masks is used
+	int reps = 3;
+	std::vector<string> paths;
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "--reps" && a+1 < argc)
+			reps = std::max(1, atoi(argv[++a]));
+		else
+			paths.push_back(arg);
+	}
+
+	//reference: the union-find backend, which labels the whole frame with the box convention
+	//of this tree (w = max_x - min_x). Every registered backend is checked; grass-fire (which
+	//misses blobs touching row or column 0) and the floodFill code of the forked tree, kept
+	//here for comparison, are not expected to match
+	std::vector<Backend> backends;
+	for (const LabelingBackend *lb = labelingBackends(); lb->name; lb++)
+	{
+		Backend backend = { lb->name, lb->extract, lb->method != GRASSFIRE, true };
+		backends.push_back(backend);
+	}
+	Backend floodfill_tree = { "floodfill_tree", extractBlobsFloodFillTree, false, false };
+	backends.push_back(floodfill_tree);
+
+	//masks: the given files or synthetic masks of every shape, with and without shadows
+	std::vector<Mat> masks;
+	for (size_t p = 0; p < paths.size(); p++)
+	{
+		Mat mask = imread(paths[p], IMREAD_GRAYSCALE);
+		if (!mask.data) {
+			cout << "Could not read mask " << paths[p] << endl;
+			return -1;
+		}
+		masks.push_back(mask);
+	}
+	if (paths.empty())
+	{
+		for (int shape = SHAPE_RECT; shape <= SHAPE_NOISE; shape++)
+			for (int seed = 1; seed <= 8; seed++)
+			{
+				MaskSpec spec = { Size(320 + 16*seed, 240 + 8*seed), 0.05 * seed, 10 * seed, (SHAPE)shape, (seed % 2) ? 0.25 : 0.0, (uint64_t)seed };
+				masks.push_back(syntheticMask(spec));
+			}
+	}
+
+	int failed = 0;
+	for (int connectivity = 4; connectivity <= 8; connectivity += 4)
+	{
+		std::vector<DiffStats> diffs(backends.size());
+		for (size_t b = 0; b < diffs.size(); b++)
+			memset(&diffs[b], 0, sizeof(DiffStats));
+		for (size_t m = 0; m < masks.size(); m++)
+			checkMask(masks[m], connectivity, backends, diffs, reps);
+
+		printf("connectivity %d, %d masks, reference unionfind\n", connectivity, (int)masks.size());
+		printf("%-20s %9s %9s %9s %9s %9s %9s %9s %10s\n", "backend", "identical", "matched", "off_by_1",
+				"box_diff", "missing", "(border)", "extra", "ns/pixel");
+		for (size_t b = 0; b < backends.size(); b++)
+		{
+			const DiffStats &d = diffs[b];
+			printf("%-20s %4d/%-4d %9ld %9ld %9ld %9ld %9ld %9ld %10.3f\n", backends[b].name, d.identical_masks, d.masks,
+					d.matched, d.size_off_by_one, d.box_mismatch, d.missing, d.missing_border, d.extra,
+					d.pixels ? 1e9 * d.seconds / d.pixels : 0.0);
+			if (backends[b].exact && d.identical_masks != d.masks)
+			{
+				printf("  FAILED: %s differs from the reference\n", backends[b].name);
+				failed++;
+			}
+		}
+		printf("\n");
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Frame sources: video files and prefetched image sequences
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "framesource.hpp"
+#include <stdio.h>
+#include <climits>
+#include <algorithm>
+
+ImageSequenceSource::ImageSequenceSource()
+	: first(0), next_claim(0), next_read(0), end_index(INT_MAX), stop(false)
+{
+}
+
+ImageSequenceSource::~ImageSequenceSource()
+{
+	release();
+}
+
+//file name of frame 'index'
+std::string ImageSequenceSource::frameName(int index) const
+{
+	char name[4096];
+	snprintf(name, sizeof(name), pattern.c_str(), index);
+	return name;
+}
+
+//true if the file can be opened
+static bool fileExists(const std::string &path)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return false;
+	fclose(f);
+	return true;
+}
+
+/**
+ *	Starts the decoding workers of an image sequence. The first frame is decoded before
+ *	returning, so a wrong pattern is reported here and not at the first read().
+ *
+ * \param pattern Path of the frames with a printf conversion for the frame number (e.g. "in%06d.jpg")
+ * \param prefetch Frames decoded ahead of the last one read (at least 1)
+ * \param num_workers Decoding threads (0: one per core, at most 'prefetch')
+ * \param first Number of the first frame (-1: 0 if its file exists, 1 otherwise)
+ *
+ * \return true if the first frame could be decoded
+ */
+bool ImageSequenceSource::open(const std::string &pattern, int prefetch, int num_workers, int first)
+{
+	release();
+
+	this->pattern = pattern;
+	if (first < 0)
+		first = fileExists(frameName(0)) ? 0 : 1;
+
+	Mat frame = imread(frameName(first), IMREAD_COLOR);
+	if (!frame.data)
+		return false;
+
+	prefetch = std::max(1, prefetch);
+	if (num_workers <= 0)
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	num_workers = std::min(num_workers, prefetch);
+
+	slots.assign(prefetch, Slot());
+	for (int i = 0; i < prefetch; i++)
+		slots[i].ready = false;
+	slots[0].index = first;
+	slots[0].frame = frame;
+	slots[0].ready = true;
+
+	this->first = first;
+	next_claim = first + 1;
+	next_read = first;
+	end_index = INT_MAX;
+	stop = false;
+	for (int w = 0; w < num_workers; w++)
+		workers.push_back(std::thread(&ImageSequenceSource::worker, this));
+	return true;
+}
+
+//decoding worker: claims the next frame inside the window, decodes it without the lock and
+//stores it in its slot. The first frame that cannot be decoded ends the sequence
+void ImageSequenceSource::worker()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;)
+	{
+		slot_free.wait(guard, [this]{ return stop || next_claim >= end_index || next_claim < next_read + (int)slots.size(); });
+		if (stop || next_claim >= end_index)
+			return;
+
+		int index = next_claim++;
+		guard.unlock();
+		Mat frame = imread(frameName(index), IMREAD_COLOR);
+		guard.lock();
+
+		if (!frame.data)
+		{
+			end_index = std::min(end_index, index);
+			slot_ready.notify_all();
+			slot_free.notify_all(); //other workers waiting for the window stop too
+			continue;
+		}
+		Slot &slot = slots[(index - first) % slots.size()];
+		slot.index = index;
+		slot.frame = frame;
+		slot.ready = true;
+		slot_ready.notify_all();
+	}
+}
+
+/**
+ *	Delivers the next frame of the sequence, waiting for its decoding if it is not ready.
+ *
+ * \param frame Decoded frame (BGR)
+ *
+ * \return false at the end of the sequence (or if it is not opened)
+ */
+bool ImageSequenceSource::read(Mat &frame)
+{
+	if (!isOpened())
+		return false;
+
+	std::unique_lock<std::mutex> guard(lock);
+	int index = next_read;
+	Slot &slot = slots[(index - first) % slots.size()];
+	slot_ready.wait(guard, [&]{ return (slot.ready && slot.index == index) || index >= end_index; });
+	if (!slot.ready || slot.index != index)
+	{
+		frame.release();
+		return false;
+	}
+
+	frame = slot.frame;
+	slot.frame = Mat();
+	slot.ready = false;
+	next_read++;
+	slot_free.notify_all();
+	return true;
+}
+
+void ImageSequenceSource::release()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stop = true;
+	}
+	slot_free.notify_all();
+	for (size_t w = 0; w < workers.size(); w++)
+		workers[w].join();
+	workers.clear();
+	slots.clear();
+}
+
+/**
+ *	Opens the source of a sequence: a numbered image pattern (e.g. ".../input/in%06d.jpg")
+ *	is decoded ahead by an ImageSequenceSource, anything else is read by a VideoCapture.
+ *
+ * \param input Video file or image pattern
+ * \param prefetch Frames decoded ahead for image patterns (0: decode on read with a VideoCapture)
+ * \param num_workers Decoding threads of the image sequence (0: one per core)
+ *
+ * \return Opened source (empty if the input cannot be opened)
+ */
+Ptr<FrameSource> openFrameSource(const std::string &input, int prefetch, int num_workers)
+{
+	if (prefetch > 0 && input.find('%') != std::string::npos)
+	{
+		Ptr<ImageSequenceSource> sequence = makePtr<ImageSequenceSource>();
+		if (!sequence->open(input, prefetch, num_workers))
+			return Ptr<FrameSource>();
+		return sequence;
+	}
+
+	Ptr<VideoSource> video = makePtr<VideoSource>(input);
+	if (!video->isOpened())
+		return Ptr<FrameSource>();
+	return video;
+}
@@ -0,0 +1,105 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Frame sources: video files and prefetched image sequences
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class ImageSequenceSource
+ * \brief Image-sequence reader that decodes the numbered files ahead on a pool of workers
+ *
+ * Frames of a pattern such as ".../input/in%06d.jpg" are claimed in order by the workers,
+ * decoded in parallel and delivered in order by read(). At most 'prefetch' frames are
+ * decoded ahead of the last one read (one slot each), so memory is bounded and a slow
+ * consumer stops the workers. The sequence ends at the first number whose file is missing
+ * or cannot be decoded.
+ */
+
+#ifndef FRAMESOURCE_H_INCLUDE
+#define FRAMESOURCE_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace cv;
+
+/// Sequential source of frames (read() returns false at the end of the sequence)
+class FrameSource
+{
+public:
+	virtual ~FrameSource() {}
+	virtual bool read(Mat &frame) = 0;
+};
+
+/// Frames of a VideoCapture (video file, camera or image pattern decoded on read), either
+/// given by the caller or opened and owned by the source
+class VideoSource : public FrameSource
+{
+public:
+	explicit VideoSource(VideoCapture &cap) : cap(cap) {}
+	explicit VideoSource(const std::string &input) : own(input), cap(own) {}
+	bool isOpened() const { return cap.isOpened(); }
+	bool read(Mat &frame) { return cap.read(frame); }
+
+private:
+	VideoCapture own;
+	VideoCapture &cap;
+};
+
+class ImageSequenceSource : public FrameSource
+{
+public:
+	ImageSequenceSource();
+	~ImageSequenceSource();
+
+	//starts decoding 'pattern' (printf format with the frame number) from frame 'first' (-1: 0 or
+	//1, the first one found). Returns false if the first frame cannot be read
+	bool open(const std::string &pattern, int prefetch=8, int num_workers=0, int first=-1);
+	bool isOpened() const { return !workers.empty(); }
+	bool read(Mat &frame);
+
+	//stops and joins the workers
+	void release();
+
+private:
+	/// Decoded frame waiting to be read
+	struct Slot {
+		int index;  /* frame number of the slot content */
+		bool ready; /* frame decoded and not read yet   */
+		Mat frame;
+	};
+
+	std::string frameName(int index) const;
+	void worker();
+
+	std::string pattern;
+	std::vector<Slot> slots;             /* frame i is kept in slot (i - first) % slots.size() */
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable slot_ready;  /* a frame was decoded or the end was found     */
+	std::condition_variable slot_free;   /* a frame was read (the window moved) or stop  */
+	int first;                           /* number of the first frame                    */
+	int next_claim;                      /* next frame to decode                         */
+	int next_read;                       /* next frame to deliver                        */
+	int end_index;                       /* first missing frame (INT_MAX until found)    */
+	bool stop;
+};
+
+/*
+* Headers of frame source functions
+*
+*/
+
+//opens 'input' as an image sequence with prefetching if it is a numbered pattern (contains '%')
+//and 'prefetch' > 0, or with a VideoCapture otherwise. Returns an empty pointer if it cannot be opened
+Ptr<FrameSource> openFrameSource(const std::string &input, int prefetch=8, int num_workers=0);
+
+#endif
@@ -0,0 +1,804 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Fast connected component labeling backends for extractBlobs
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "blobs.hpp"
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//bounding box and raw moments accumulated for each provisional label while scanning
+typedef struct BOX
+{
+	int min_x, min_y;
+	int max_x, max_y;
+	int64_t m00, m10, m01;  //pixel count and coordinate sums
+	int64_t m20, m02, m11;  //second-order sums (x*x, y*y, x*y)
+}BOX;
+
+//empty box of a blob whose first pixel is (x,y)
+static inline BOX box_new(int x, int y)
+{
+	BOX box = {x, y, x, y, 0, 0, 0, 0, 0, 0};
+	return box;
+}
+
+//add pixel (x,y) to the moments
+static inline void box_add_pixel(BOX &box, int64_t x, int64_t y)
+{
+	box.m00++;
+	box.m10 += x;
+	box.m01 += y;
+	box.m20 += x*x;
+	box.m02 += y*y;
+	box.m11 += x*y;
+}
+
+//add the pixels of columns [start,end] of row y to the moments (closed-form sums)
+static inline void box_add_run(BOX &box, int64_t start, int64_t end, int64_t y)
+{
+	int64_t n = end - start + 1;
+	int64_t sx = (start + end) * n / 2;
+	//sum of x*x over [start,end] = S(end) - S(start-1), S(k) = k(k+1)(2k+1)/6
+	int64_t sxx = end*(end+1)*(2*end+1)/6 - (start-1)*start*(2*start-1)/6;
+	box.m00 += n;
+	box.m10 += sx;
+	box.m01 += n*y;
+	box.m20 += sxx;
+	box.m02 += n*y*y;
+	box.m11 += sx*y;
+}
+
+//merge box 'src' into 'dst'
+static inline void box_merge(BOX &dst, const BOX &src)
+{
+	if (src.min_x < dst.min_x) dst.min_x = src.min_x;
+	if (src.min_y < dst.min_y) dst.min_y = src.min_y;
+	if (src.max_x > dst.max_x) dst.max_x = src.max_x;
+	if (src.max_y > dst.max_y) dst.max_y = src.max_y;
+	dst.m00 += src.m00;
+	dst.m10 += src.m10;
+	dst.m01 += src.m01;
+	dst.m20 += src.m20;
+	dst.m02 += src.m02;
+	dst.m11 += src.m11;
+}
+
+//find the representative label of 'i' (with path halving)
+static inline int uf_find(std::vector<int> &parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+//merge the sets of 'a' and 'b'. The smallest label is kept as root so that the
+//root is always the first label created for the blob (first pixel in raster order)
+static inline int uf_union(std::vector<int> &parent, int a, int b)
+{
+	a = uf_find(parent, a);
+	b = uf_find(parent, b);
+	if (a < b)
+	{
+		parent[b] = a;
+		return a;
+	}
+	parent[a] = b;
+	return b;
+}
+
+//merge the boxes of equivalent labels into their root and append one blob per root, with
+//its features computed from the merged moments.
+//Roots are visited in creation order, i.e. raster order of the first pixel of each blob
+static void boxes_to_blobs(std::vector<int> &parent, std::vector<BOX> &boxes, std::vector<cvBlob> &bloblist)
+{
+	for (int i = 0; i < (int)parent.size(); i++)
+	{
+		int root = uf_find(parent, i);
+		if (root == i)
+			continue;
+		box_merge(boxes[root], boxes[i]);
+	}
+
+	int counter = 0;
+	for (int i = 0; i < (int)parent.size(); i++)
+	{
+		if (parent[i] != i)
+			continue;
+		const BOX &box = boxes[i];
+		counter++;
+		cvBlob blob = initBlob(counter, box.min_x, box.min_y, box.max_x - box.min_x, box.max_y - box.min_y);
+		setBlobMoments(blob, (double)box.m00, (double)box.m10, (double)box.m01, (double)box.m20, (double)box.m02, (double)box.m11);
+		bloblist.push_back(blob);
+	}
+}
+
+//labels of a band of rows, with its own equivalence table
+typedef struct STRIPE
+{
+	std::vector<int> parent;    //equivalence table
+	std::vector<BOX> boxes;     //bounding box of each provisional label
+	std::vector<int> first_row; //labels of the first row (padded by one on each side, -1 is background)
+	std::vector<int> last_row;  //labels of the last row (padded)
+}STRIPE;
+
+//union-find scan of rows [row_start,row_end). Every foreground pixel takes the label of its
+//already visited neighbours (left, up and, for 8-connectivity, up-left and up-right); when
+//they disagree the labels are merged in the equivalence table
+static void labelStripe(const cv::Mat &fgmask, int row_start, int row_end, bool diagonals, STRIPE &stripe)
+{
+	std::vector<int> &parent = stripe.parent;
+	std::vector<BOX> &boxes = stripe.boxes;
+	std::vector<int> prev_row(fgmask.cols + 2, -1); //labels of the previous row (-1 is background)
+	std::vector<int> curr_row(fgmask.cols + 2, -1); //labels of the current row
+
+	for (int y = row_start; y < row_end; y++)
+	{
+		const uchar *row = fgmask.ptr<uchar>(y);
+		//rows are padded by one label on each side to avoid border checks
+		int *up = &prev_row[1];
+		int *cur = &curr_row[1];
+
+		for (int x = 0; x < fgmask.cols; x++)
+		{
+			if (row[x] != 255)
+			{
+				cur[x] = -1;
+				continue;
+			}
+
+			//label of the already visited neighbours
+			int label = cur[x-1];
+			if (up[x] >= 0)
+				label = (label >= 0) ? uf_union(parent, label, up[x]) : up[x];
+			if (diagonals)
+			{
+				if (up[x-1] >= 0)
+					label = (label >= 0) ? uf_union(parent, label, up[x-1]) : up[x-1];
+				if (up[x+1] >= 0)
+					label = (label >= 0) ? uf_union(parent, label, up[x+1]) : up[x+1];
+			}
+
+			if (label < 0)
+			{
+				//new blob (first pixel in raster order)
+				label = (int)parent.size();
+				parent.push_back(label);
+				boxes.push_back(box_new(x, y));
+			}
+			else
+			{
+				BOX &box = boxes[label];
+				if (x < box.min_x) box.min_x = x;
+				if (x > box.max_x) box.max_x = x;
+				box.max_y = y; //rows are visited in increasing order
+			}
+			box_add_pixel(boxes[label], x, y);
+			cur[x] = label;
+		}
+		if (y == row_start)
+			stripe.first_row = curr_row;
+		prev_row.swap(curr_row);
+	}
+	stripe.last_row.swap(prev_row);
+}
+
+/**
+ *	Union-find blob extraction. The mask is scanned once in raster order keeping only the
+ *	labels of the previous and the current row (see labelStripe). The bounding box of
+ *	each provisional label is updated during the scan and the boxes of equivalent labels
+ *	are merged at the end, so no pixel stack is needed.
+ *
+ *	Output follows extractBlobsGrassFire: blobs are sorted by their first pixel in raster
+ *	order, IDs start at 1 and w/h are the max-min coordinate differences. Area, centroid,
+ *	second-order moments and fill ratio are accumulated in the same scan.
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsUnionFind(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!fgmask.data || fgmask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	//clear blob list (to fill with this function)
+	bloblist.clear();
+
+	STRIPE stripe;
+	labelStripe(fgmask, 0, fgmask.rows, connectivity == 8, stripe);
+
+	//build one blob per set of equivalent labels
+	boxes_to_blobs(stripe.parent, stripe.boxes, bloblist);
+
+	//return OK code
+	return 1;
+}
+
+//minimum number of rows labeled by a thread in extractBlobsParallel
+#define MIN_STRIPE_ROWS 16
+
+/**
+ *	Parallel union-find blob extraction. The mask is split in horizontal stripes that are
+ *	labeled at the same time (cv::parallel_for_), each with its own equivalence table. The
+ *	tables are then joined with consecutive label ranges and the labels of the last row of
+ *	each stripe are merged with the touching labels of the first row of the next one.
+ *
+ *	Labels keep the raster order of the serial scan (stripe by stripe), so the output is
+ *	identical to extractBlobsUnionFind.
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsParallel(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!fgmask.data || fgmask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	bool diagonals = (connectivity == 8);
+	int num_stripes = std::max(1, std::min(cv::getNumThreads(), fgmask.rows / MIN_STRIPE_ROWS));
+	std::vector<STRIPE> stripes(num_stripes);
+
+	//clear blob list (to fill with this function)
+	bloblist.clear();
+
+	//label each stripe on its own
+	parallel_for_(Range(0, num_stripes), [&](const Range &range){
+		for (int k = range.start; k < range.end; k++)
+			labelStripe(fgmask, k*fgmask.rows/num_stripes, (k+1)*fgmask.rows/num_stripes, diagonals, stripes[k]);
+	});
+
+	//join the equivalence tables, each stripe taking the next range of labels
+	std::vector<int> parent;
+	std::vector<BOX> boxes;
+	std::vector<int> base(num_stripes);
+	for (int k = 0; k < num_stripes; k++)
+	{
+		base[k] = (int)parent.size();
+		for (size_t i = 0; i < stripes[k].parent.size(); i++)
+			parent.push_back(stripes[k].parent[i] + base[k]);
+		boxes.insert(boxes.end(), stripes[k].boxes.begin(), stripes[k].boxes.end());
+	}
+
+	//merge the labels touching across each seam
+	for (int k = 1; k < num_stripes; k++)
+	{
+		const int *up = &stripes[k-1].last_row[1];
+		const int *cur = &stripes[k].first_row[1];
+		for (int x = 0; x < fgmask.cols; x++)
+		{
+			if (cur[x] < 0)
+				continue;
+			int label = cur[x] + base[k];
+			if (up[x] >= 0)
+				uf_union(parent, label, up[x] + base[k-1]);
+			if (diagonals)
+			{
+				if (up[x-1] >= 0)
+					uf_union(parent, label, up[x-1] + base[k-1]);
+				if (up[x+1] >= 0)
+					uf_union(parent, label, up[x+1] + base[k-1]);
+			}
+		}
+	}
+
+	//build one blob per set of equivalent labels
+	boxes_to_blobs(parent, boxes, bloblist);
+
+	//return OK code
+	return 1;
+}
+
+//horizontal run of foreground (255) pixels in a row
+typedef struct RUN
+{
+	int start, end; //first and last column (inclusive)
+	int label;      //provisional label
+}RUN;
+
+//true if any of the 8 bytes of 'v' is 255
+static inline bool has_fg_byte(uint64_t v)
+{
+	v = ~v;
+	return ((v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL) != 0;
+}
+
+//encode the foreground (255) pixels of a row as runs. Background and shadow bytes
+//are skipped 8 at a time
+static void encode_runs(const uchar *row, int cols, std::vector<RUN> &runs)
+{
+	runs.clear();
+	int x = 0;
+	while (x < cols)
+	{
+		//skip words without any foreground byte
+		while (x + 8 <= cols)
+		{
+			uint64_t word;
+			memcpy(&word, row + x, sizeof(word));
+			if (has_fg_byte(word))
+				break;
+			x += 8;
+		}
+		while (x < cols && row[x] != 255)
+			x++;
+		if (x >= cols)
+			break;
+
+		RUN run;
+		run.start = x;
+		while (x < cols && row[x] == 255)
+			x++;
+		run.end = x - 1;
+		run.label = -1;
+		runs.push_back(run);
+	}
+}
+
+/**
+ *	Run-length blob extraction. Each row of the mask is encoded as runs of foreground
+ *	(255) pixels, and runs overlapping a run of the previous row are joined with the
+ *	union-find equivalence table used by extractBlobsUnionFind. Two runs are connected
+ *	if they share a column (4-connectivity) or if they share or touch a column diagonally
+ *	(8-connectivity). Bounding boxes and moments are built from the runs (closed-form sums),
+ *	so the labeling cost depends on the number of runs and not on the number of foreground pixels.
+ *
+ *	Output is identical to extractBlobsUnionFind.
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsRunLength(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!fgmask.data || fgmask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	//required variables for connected component analysis
+	std::vector<int> parent; //equivalence table
+	std::vector<BOX> boxes; //bounding box of each provisional label
+	std::vector<RUN> prev_runs, curr_runs;
+	int reach = (connectivity == 8) ? 1 : 0; //extra columns a run reaches in the previous row
+
+	//clear blob list (to fill with this function)
+	bloblist.clear();
+
+	for (int y = 0; y < fgmask.rows; y++)
+	{
+		encode_runs(fgmask.ptr<uchar>(y), fgmask.cols, curr_runs);
+
+		//both run lists are sorted, so overlaps are found with a single merge pass
+		size_t j = 0;
+		for (size_t i = 0; i < curr_runs.size(); i++)
+		{
+			RUN &run = curr_runs[i];
+			int label = -1;
+
+			//previous runs ending before this one cannot touch it nor any later run
+			while (j < prev_runs.size() && prev_runs[j].end + reach < run.start)
+				j++;
+			for (size_t k = j; k < prev_runs.size() && prev_runs[k].start <= run.end + reach; k++)
+				label = (label >= 0) ? uf_union(parent, label, prev_runs[k].label) : prev_runs[k].label;
+
+			if (label < 0)
+			{
+				//new blob (first run in raster order)
+				label = (int)parent.size();
+				parent.push_back(label);
+				boxes.push_back(box_new(run.start, y));
+				boxes.back().max_x = run.end;
+			}
+			else
+			{
+				BOX &box = boxes[label];
+				if (run.start < box.min_x) box.min_x = run.start;
+				if (run.end > box.max_x) box.max_x = run.end;
+				box.max_y = y;
+			}
+			box_add_run(boxes[label], run.start, run.end, y);
+			run.label = label;
+		}
+		prev_runs.swap(curr_runs);
+	}
+
+	//build one blob per set of equivalent labels
+	boxes_to_blobs(parent, boxes, bloblist);
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Prepares the mask for cv::floodFill: a one pixel border is added and the mask is inverted
+ *	(foreground 255 -> 0, anything else, including shadows, -> 255), so that every fill
+ *	stops at the border. Rows are converted 32 (AVX2) or 16 (SSE2) pixels at a time.
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image)
+ * \param temp_fgmask Prepared mask (fgmask.rows+2 x fgmask.cols+2)
+ */
+void prepareFloodFillMask(const cv::Mat &fgmask, cv::Mat &temp_fgmask)
+{
+	int cols = fgmask.cols;
+	temp_fgmask.create(fgmask.rows+2, cols+2, CV_8UC1);
+
+	//top and bottom borders
+	memset(temp_fgmask.ptr<uchar>(0), 255, cols+2);
+	memset(temp_fgmask.ptr<uchar>(fgmask.rows+1), 255, cols+2);
+
+	for (int y=0; y<fgmask.rows; y++)
+	{
+		const uchar *src = fgmask.ptr<uchar>(y);
+		uchar *dst = temp_fgmask.ptr<uchar>(y+1);
+		dst[0] = 255; //left border
+		dst[cols+1] = 255; //right border
+		dst++;
+
+		int x = 0;
+#if defined(__AVX2__)
+		const __m256i fg32 = _mm256_set1_epi8((char)255);
+		for (; x+32<=cols; x+=32)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)(src+x));
+			//cmpeq gives 255 for foreground, xor turns it into 0 and everything else into 255
+			_mm256_storeu_si256((__m256i*)(dst+x), _mm256_xor_si256(_mm256_cmpeq_epi8(v, fg32), fg32));
+		}
+#endif
+#if defined(__SSE2__)
+		const __m128i fg16 = _mm_set1_epi8((char)255);
+		for (; x+16<=cols; x+=16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src+x));
+			_mm_storeu_si128((__m128i*)(dst+x), _mm_xor_si128(_mm_cmpeq_epi8(v, fg16), fg16));
+		}
+#endif
+		for (; x<cols; x++)
+			dst[x] = (src[x]==255) ? 0 : 255;
+	}
+}
+
+/**
+ *	Finds the next foreground (0) pixel of the prepared mask in raster order, starting at (x,y)
+ *	and only inside the border. Background bytes are skipped 32 (AVX2) or 16 (SSE2) at a time.
+ *
+ * \param temp_fgmask Mask prepared with prepareFloodFillMask
+ * \param x Column to start at, updated with the column of the seed
+ * \param y Row to start at, updated with the row of the seed
+ *
+ * \return true if a seed was found
+ */
+bool findNextSeed(const cv::Mat &temp_fgmask, int &x, int &y)
+{
+	int last_col = temp_fgmask.cols-2; //last column inside the border
+	int last_row = temp_fgmask.rows-2; //last row inside the border
+
+	for (; y<=last_row; y++, x=1)
+	{
+		const uchar *row = temp_fgmask.ptr<uchar>(y);
+#if defined(__AVX2__)
+		for (; x+32<=last_col+1; x+=32)
+		{
+			int bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(row+x)), _mm256_setzero_si256()));
+			if (bits)
+			{
+				x += __builtin_ctz(bits);
+				return true;
+			}
+		}
+#endif
+#if defined(__SSE2__)
+		for (; x+16<=last_col+1; x+=16)
+		{
+			int bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row+x)), _mm_setzero_si128()));
+			if (bits)
+			{
+				x += __builtin_ctz(bits);
+				return true;
+			}
+		}
+#endif
+		for (; x<=last_col; x++)
+			if (row[x]==0)
+				return true;
+	}
+	return false;
+}
+
+//value of the pixels of the blob being filled, until its moments are taken
+#define FILL_PENDING 1
+
+/**
+ *	cv::floodFill blob extraction (the labeling of the "Grass-Fire using FloodFill" tree).
+ *	The mask is bordered and inverted with prepareFloodFillMask and every foreground pixel
+ *	found by findNextSeed is filled. Each blob is filled with a temporary value and its
+ *	bounding box is scanned once to take its moments and mark it as done.
+ *
+ *	Output follows extractBlobsUnionFind: blobs in raster order of their first pixel, in
+ *	fgmask coordinates, with w/h as max-min coordinate differences (the floodFill Rect
+ *	size minus one).
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsFloodFill(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!fgmask.data || fgmask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	cv::Mat temp_fgmask;
+	prepareFloodFillMask(fgmask, temp_fgmask);
+	bloblist.clear();
+
+	int x = 1, y = 1;
+	while (findNextSeed(temp_fgmask, x, y))
+	{
+		cv::Rect rect;
+		floodFill(temp_fgmask, cv::Point(x,y), FILL_PENDING, &rect, 0, 0, connectivity);
+
+		//moments of the filled pixels, in fgmask coordinates (the border adds 1)
+		BOX box = box_new(rect.x-1, rect.y-1);
+		box.max_x = rect.x + rect.width - 2;
+		box.max_y = rect.y + rect.height - 2;
+		for (int r = rect.y; r < rect.y + rect.height; r++)
+		{
+			uchar *row = temp_fgmask.ptr<uchar>(r);
+			for (int c = rect.x; c < rect.x + rect.width; c++)
+			{
+				if (row[c] != FILL_PENDING)
+					continue;
+				int start = c;
+				while (c < rect.x + rect.width && row[c] == FILL_PENDING)
+					row[c++] = 255;
+				box_add_run(box, start-1, c-2, r-1);
+			}
+		}
+
+		cvBlob blob = initBlob((int)bloblist.size()+1, box.min_x, box.min_y, box.max_x - box.min_x, box.max_y - box.min_y);
+		setBlobMoments(blob, (double)box.m00, (double)box.m10, (double)box.m01, (double)box.m20, (double)box.m02, (double)box.m11);
+		bloblist.push_back(blob);
+		x++;
+	}
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Blob extraction with cv::connectedComponentsWithStats on the foreground (255) pixels.
+ *	Boxes and areas come from the component statistics; the labels image is scanned once,
+ *	run by run, for the remaining moments and for the raster order of the first pixel of
+ *	each component, so the output follows extractBlobsUnionFind.
+ *
+ * \param fgmask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param bloblist List with found blobs
+ * \param connectivity 4 or 8 neighbourhood
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsCCStats(const cv::Mat &fgmask, std::vector<cvBlob> &bloblist, int connectivity)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!fgmask.data || fgmask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	//shadows (127) are background
+	cv::Mat binary, labels, stats, centroids;
+	cv::compare(fgmask, 255, binary, cv::CMP_EQ);
+	int num = cv::connectedComponentsWithStats(binary, labels, stats, centroids, connectivity, CV_32S);
+
+	//moments (label 0 is the background) and labels in raster order of their first pixel
+	std::vector<BOX> boxes(std::max(num, 1));
+	std::vector<int> order;
+	order.reserve(num);
+	std::vector<uchar> seen(std::max(num, 1), 0);
+	for (int r = 0; r < labels.rows; r++)
+	{
+		const int *row = labels.ptr<int>(r);
+		for (int c = 0; c < labels.cols; )
+		{
+			int l = row[c];
+			int start = c;
+			while (c < labels.cols && row[c] == l)
+				c++;
+			if (l == 0)
+				continue;
+			if (!seen[l])
+			{
+				seen[l] = 1;
+				order.push_back(l);
+				boxes[l] = box_new(start, r);
+			}
+			box_add_run(boxes[l], start, c-1, r);
+		}
+	}
+
+	bloblist.clear();
+	bloblist.reserve(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const int *st = stats.ptr<int>(order[i]);
+		const BOX &box = boxes[order[i]];
+		cvBlob blob = initBlob((int)i+1, st[cv::CC_STAT_LEFT], st[cv::CC_STAT_TOP], st[cv::CC_STAT_WIDTH]-1, st[cv::CC_STAT_HEIGHT]-1);
+		setBlobMoments(blob, (double)st[cv::CC_STAT_AREA], (double)box.m10, (double)box.m01, (double)box.m20, (double)box.m02, (double)box.m11);
+		bloblist.push_back(blob);
+	}
+
+	//return OK code
+	return 1;
+}
+
+//blobs ordered by the top-left corner of their bounding box
+static bool blob_before(const cvBlob &a, const cvBlob &b)
+{
+	return (a.y != b.y) ? a.y < b.y : a.x < b.x;
+}
+
+/**
+ *	Incremental blob extraction for a mask that changes only in some bands of rows between
+ *	calls (e.g. the stationary mask, see the dirty_bands of extractStationaryFG).
+ *
+ *	The blobs of the previous mask are kept in 'cache'. Only the rows of the dirty bands are
+ *	relabeled, together with the rows of any cached blob touching them (or touching the rows
+ *	of another relabeled blob), so a blob is never split between the cache and the relabeled
+ *	rows. Each range of relabeled rows is labeled with the 'method' backend; the other
+ *	cached blobs are reused as they are. Without a valid cache (first call, change of size
+ *	or connectivity) the whole mask is labeled.
+ *
+ *	The blobs are the same as those of a full extractBlobs call, but they are sorted by the
+ *	top-left corner of their bounding box (y, then x) and IDs are renumbered from 1.
+ *
+ * \param mask Foreground/Background segmentation mask (1-channel binary image, 255 is foreground)
+ * \param dirty_bands One flag per band of DIRTY_BAND_ROWS rows: 1 if the band changed since the previous call
+ * \param connectivity 4 or 8 neighbourhood
+ * \param cache Blobs of the previous call (updated)
+ * \param bloblist List with found blobs
+ * \param method Labeling backend (see LABELING typedef)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int extractBlobsIncremental(const cv::Mat &mask, const std::vector<uchar> &dirty_bands, int connectivity, IncrementalBlobs &cache, std::vector<cvBlob> &bloblist, LABELING method)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!mask.data || mask.type() != CV_8UC1 || (connectivity != 4 && connectivity != 8)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	int rows = mask.rows;
+	int num_bands = (rows + DIRTY_BAND_ROWS - 1) / DIRTY_BAND_ROWS;
+
+	//no usable cache: label the whole mask
+	if (cache.size != mask.size() || cache.connectivity != connectivity || (int)dirty_bands.size() != num_bands)
+	{
+		int ret = extractBlobs(mask, cache.bloblist, connectivity, method);
+		if (ret < 0)
+			return ret;
+		std::sort(cache.bloblist.begin(), cache.bloblist.end(), blob_before);
+		for (size_t i = 0; i < cache.bloblist.size(); i++)
+			cache.bloblist[i].ID = (int)i + 1;
+		cache.size = mask.size();
+		cache.connectivity = connectivity;
+		bloblist = cache.bloblist;
+		return 1;
+	}
+
+	//rows to relabel: the dirty bands...
+	std::vector<uchar> marked(rows, 0);
+	bool any = false;
+	for (int b = 0; b < num_bands; b++)
+	{
+		if (!dirty_bands[b])
+			continue;
+		any = true;
+		for (int y = b*DIRTY_BAND_ROWS; y < std::min(rows, (b+1)*DIRTY_BAND_ROWS); y++)
+			marked[y] = 1;
+	}
+	if (!any)
+	{
+		bloblist = cache.bloblist;
+		return 1;
+	}
+
+	//...and the rows of every cached blob with a marked row in or next to its box, until no
+	//more blobs are added. Blobs left out do not touch any relabeled row
+	std::vector<uchar> stale(cache.bloblist.size(), 0);
+	for (bool grown = true; grown; )
+	{
+		grown = false;
+		for (size_t i = 0; i < cache.bloblist.size(); i++)
+		{
+			if (stale[i])
+				continue;
+			const cvBlob &blob = cache.bloblist[i];
+			int y0 = std::max(0, blob.y - 1), y1 = std::min(rows - 1, blob.y + blob.h + 1);
+			int y = y0;
+			while (y <= y1 && !marked[y])
+				y++;
+			if (y > y1)
+				continue;
+			stale[i] = 1;
+			grown = true;
+			for (y = blob.y; y <= blob.y + blob.h; y++)
+				marked[y] = 1;
+		}
+	}
+
+	//keep the cached blobs that are still valid
+	std::vector<cvBlob> merged;
+	merged.reserve(cache.bloblist.size());
+	for (size_t i = 0; i < cache.bloblist.size(); i++)
+		if (!stale[i])
+			merged.push_back(cache.bloblist[i]);
+
+	//relabel each range of marked rows and move its blobs to mask coordinates
+	std::vector<cvBlob> range_blobs;
+	for (int y = 0; y < rows; )
+	{
+		if (!marked[y])
+		{
+			y++;
+			continue;
+		}
+		int y_end = y;
+		while (y_end < rows && marked[y_end])
+			y_end++;
+
+		range_blobs.clear();
+		extractBlobs(mask.rowRange(y, y_end), range_blobs, connectivity, method);
+		for (size_t i = 0; i < range_blobs.size(); i++)
+		{
+			range_blobs[i].y += y;
+			range_blobs[i].cy += y;
+			merged.push_back(range_blobs[i]);
+		}
+		y = y_end;
+	}
+
+	std::sort(merged.begin(), merged.end(), blob_before);
+	for (size_t i = 0; i < merged.size(); i++)
+		merged[i].ID = (int)i + 1;
+
+	cache.bloblist.swap(merged);
+	bloblist = cache.bloblist;
+
+	//return OK code
+	return 1;
+}
@@ -9,6 +9,7 @@
 
 //system libraries C/C++
 #include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
 #include <sstream>
 
@@ -22,6 +23,24 @@
 //include for blob-related functions
 #include "blobs.hpp"
 
+//include for the multi-threaded frame pipeline
+#include "pipeline.hpp"
+
+//include for batch processing of sequences
+#include "batch.hpp"
+
+//include for the class models
+#include "classifier.hpp"
+
+//include for the results writer
+#include "results.hpp"
+
+//include for mask recording and replay
+#include "maskstream.hpp"
+
+//include for parameter sweeps
+#include "sweep.hpp"
+
 //namespaces
 using namespace cv; //avoid using 'cv' to declare OpenCV functions and variables (cv::Mat or Mat)
 using namespace std;
@@ -29,21 +48,14 @@ using namespace std;
 #define MIN_WIDTH 20
 #define MIN_HEIGHT 20
 
+//labeling backend when --labeling is not given (builds may set it, e.g. -DDEFAULT_LABELING=FLOODFILL)
+#ifndef DEFAULT_LABELING
+#define DEFAULT_LABELING UNIONFIND
+#endif
+
 //main function
 int main(int argc, char ** argv) 
 {
-	Mat frame; // current Frame
-	Mat fgmask; // foreground mask
-	std::vector<cvBlob> bloblist; // list for blobs
-	std::vector<cvBlob> bloblistFiltered; // list for blobs
-
-	// STATIONARY BLOBS
-	Mat fgmask_history; // STATIONARY foreground mask
-	Mat sfgmask; // STATIONARY foreground mask
-	std::vector<cvBlob> sbloblist; // list for STATIONARY blobs
-	std::vector<cvBlob> sbloblistFiltered; // list for STATIONARY blobs
-
-
 	double t, acum_t; //variables for execution time
 		int t_freq = getTickFrequency();
 
@@ -88,10 +100,192 @@ int main(int argc, char ** argv)
 		//changed connectivity location
 		int connectivity = 8; // 4 or 8
 
+		//frames buffered between pipeline stages (a full queue stops its producer)
+		int queue_depth = 4;
+
+		//command line options
+		//	--headless        no display: no rendering nor key polling, frames are processed as fast as possible
+		//	--batch <list>    process the sequences of <list> in parallel (always headless)
+		//	--jobs <N>        sequences processed at the same time in batch mode, parameter combinations
+		//	                  in sweep mode (default: one per core)
+		//	--models <file>   class models used by classifyBlobs (default: built-in aspect ratio models)
+		//	--scale <N>       analysis at 1/N resolution (1, 2, 4 or 8): MOG2, stationary detection and
+		//	                  labeling run on the downscaled frame, blobs are reported at full resolution
+		//	--deadline <ms>   time budget per frame: frames late for it are not analyzed (default: 0, never skip)
+		//	--prefetch <N>    image sequences (image_path pattern): frames decoded ahead on a pool of
+		//	                  workers (default 8, 0: decode each frame on read with VideoCapture)
+		//	--decoders <N>    decoding workers of the image sequences (default: one per core)
+		//	--masks <m>       masks written with the per-frame blobs of each sequence: none (default),
+		//	                  png or raw (see ResultsWriter)
+		//	--record-masks    foreground masks of each sequence recorded to <results>/fgmask.rle
+		//	--replay          masks of <results>/fgmask.rle analyzed instead of the input (no decoding
+		//	                  nor MOG2, always headless): tuning of the steps after background subtraction
+		//	--blob-log        per-frame blobs written to the binary blobs.log instead of blobs.csv
+		//	--sweep <grid>    parameter sweep instead of the analysis: every combination of the grid, e.g.
+		//	                  "secs=5,10,15;i_cost=3:7:2;stat_th=0.45,0.5,0.55;min_width=10,20" (parameters
+		//	                  fps, secs, i_cost, d_cost, stat_th, min_width, min_height), is evaluated on the
+		//	                  masks of each sequence, computed once (or replayed with --replay); one row per
+		//	                  sequence and combination in <results>/sweep.csv (always headless)
+		//	--labeling <name> connected component labeling backend: grassfire, unionfind, runlength,
+		//	                  unionfind_parallel, floodfill or ccstats (in batch mode, the default of the list)
+		bool headless = false;
+		string batch_list = "";
+		int num_workers = 0;
+		string models_path = "";
+		int analysis_scale = 1;
+		double deadline_ms = 0;
+		const LabelingBackend *labeling = findLabelingBackend(DEFAULT_LABELING);
+		int prefetch = 8;
+		MASK_OUTPUT masks = MASKS_NONE;
+		BLOB_OUTPUT blob_output = BLOBS_CSV;
+		bool record_masks = false;
+		bool replay_masks = false;
+		string sweep_spec = "";
+		int decode_workers = 0;
+		for (int a=1; a<argc; a++)
+		{
+			string arg = argv[a];
+			if (arg == "--headless")
+				headless = true;
+			else if (arg == "--batch" && a+1 < argc)
+				batch_list = argv[++a];
+			else if (arg == "--jobs" && a+1 < argc)
+				num_workers = atoi(argv[++a]);
+			else if (arg == "--models" && a+1 < argc)
+				models_path = argv[++a];
+			else if (arg == "--scale" && a+1 < argc)
+				analysis_scale = atoi(argv[++a]);
+			else if (arg == "--deadline" && a+1 < argc)
+				deadline_ms = atof(argv[++a]);
+			else if (arg == "--prefetch" && a+1 < argc)
+				prefetch = std::max(0, atoi(argv[++a]));
+			else if (arg == "--decoders" && a+1 < argc)
+				decode_workers = std::max(0, atoi(argv[++a]));
+			else if (arg == "--masks" && a+1 < argc)
+			{
+				string value = argv[++a];
+				if (value == "none")
+					masks = MASKS_NONE;
+				else if (value == "png")
+					masks = MASKS_PNG;
+				else if (value == "raw")
+					masks = MASKS_RAW;
+				else {
+					cout << "Masks output should be none, png or raw" << endl;
+					return -1;
+				}
+			}
+			else if (arg == "--record-masks")
+				record_masks = true;
+			else if (arg == "--replay")
+				replay_masks = true;
+			else if (arg == "--sweep" && a+1 < argc)
+				sweep_spec = argv[++a];
+			else if (arg == "--blob-log")
+				blob_output = BLOBS_LOG;
+			else if (arg == "--labeling" && a+1 < argc)
+			{
+				labeling = findLabelingBackend(string(argv[++a]));
+				if (!labeling){
+					cout << "Unknown labeling backend " << argv[a] << endl;
+					return -1;
+				}
+			}
+			else {
+				cout << "Unknown option " << arg << endl;
+				return -1;
+			}
+		}
+
+		if (analysis_scale != 1 && analysis_scale != 2 && analysis_scale != 4 && analysis_scale != 8){
+			cout << "Analysis scale should be 1, 2, 4 or 8" << endl;
+			return -1;
+		}
+
+		//replayed masks are never displayed: --replay implies --headless (no final waitKey either)
+		if (replay_masks)
+			headless = true;
+
+		//class models, loaded once and shared (read-only) by all the sequences and threads
+		BlobClassifier classifier;
+		if (!models_path.empty() && loadClassifier(models_path, classifier) < 0)
+			return -1;
+
 	    if (connectivity!=4 && connectivity!=8){
 	 		std::cout << "Connectivity should be either 4 or 8, if not specified will run the default: 4"<< std::endl;
 	     }
 
+		//parameter grid of the sweep mode, expanded for each sequence from its settings
+		SweepGrid sweep_grid;
+		FILE *sweep_table = NULL;
+		if (!sweep_spec.empty())
+		{
+			if (parseSweepGrid(sweep_spec, sweep_grid) < 0)
+				return -1;
+			sweep_table = fopen((results_path + "/sweep.csv").c_str(), "w");
+			if (!sweep_table){
+				cout << "Could not create " << results_path << "/sweep.csv" << endl;
+				return -1;
+			}
+			writeSweepHeader(sweep_table);
+		}
+
+		//batch mode: sequences are processed in parallel without display, one worker per sequence
+		if (!batch_list.empty())
+		{
+			std::vector<SequenceJob> jobs;
+			if (readSequenceList(batch_list, results_path, jobs) < 0)
+				return -1;
+
+			PipelineConfig config;
+			config.connectivity = connectivity;
+			config.labeling = labeling->method;
+			config.min_width = MIN_WIDTH;
+			config.min_height = MIN_HEIGHT;
+			config.stationary = defaultStationaryParams();
+			config.learningrate = .0005;
+			config.queue_depth = queue_depth;
+			config.prefetch = prefetch;
+			config.decode_workers = decode_workers ? decode_workers : 2; //sequences already run in parallel
+			config.analysis_scale = analysis_scale;
+			config.deadline_ms = deadline_ms;
+			config.display = false;
+			config.classifier = models_path.empty() ? NULL : &classifier;
+			config.masks = masks;
+			config.blobs = blob_output;
+			config.record_masks = record_masks;
+			config.replay_masks = replay_masks;
+
+			//sweep mode: the sequences one after the other, the combinations of each one in parallel
+			if (sweep_table)
+			{
+				int failed = 0;
+				for (size_t j = 0; j < jobs.size(); j++)
+				{
+					PipelineConfig job_config = config;
+					if (jobs[j].labeling)
+						job_config.labeling = jobs[j].labeling->method;
+					std::vector<PipelineConfig> sweep_configs;
+					expandSweepGrid(sweep_grid, job_config, sweep_configs);
+					std::vector<SweepResult> sweep_results;
+					if (sweepSequence(jobs[j].input, jobs[j].output_dir, job_config, sweep_configs, num_workers, sweep_results) < 0)
+						failed++;
+					else
+						writeSweepRows(sweep_table, jobs[j].input, sweep_configs, sweep_results);
+				}
+				fclose(sweep_table);
+				return failed ? 1 : 0;
+			}
+
+			std::vector<SequenceResult> results;
+			t = (double)getTickCount();
+			int failed = runBatch(jobs, config, num_workers, results);
+			acum_t = (double)getTickCount() - t;
+
+			printBatchReport(results, acum_t/t_freq);
+			return failed ? 1 : 0;
+		}
+
 		//Loop for all categories
 		for (int c=0; c<NumCat; c++ )
 		{
@@ -104,113 +298,112 @@ int main(int argc, char ** argv)
 			//Loop for all sequence of each category
 			for (int s=0; s<NumSeq; s++ )
 			{
-			VideoCapture cap;//reader to grab videoframes
-
 			//Compose full path of images
 			string inputvideo = dataset_path + "/" + dataset_cat[c] + "/" + baseline_seq[s] + image_path;
 			cout << "Accessing sequence at " << inputvideo << endl;
 
-			//open the video file to check if it exists
-			cap.open(inputvideo);
-			if (!cap.isOpened()) {
-				cout << "Could not open video file " << inputvideo << endl;
-			return -1;
+			//open the video file to check if it exists (image sequences are decoded ahead, see --prefetch)
+			Ptr<FrameSource> source;
+			if (!replay_masks && !sweep_table) {
+				source = openFrameSource(inputvideo, prefetch, decode_workers);
+				if (!source) {
+					cout << "Could not open video file " << inputvideo << endl;
+				return -1;
+				}
 			}
 
 			// create directory to store results for sequence
-			string makedir_cmd = "mkdir "+results_path + "/" + dataset_cat[c] + "/" + baseline_seq[s];
+			string sequence_results = results_path + "/" + dataset_cat[c] + "/" + baseline_seq[s];
+			string makedir_cmd = "mkdir -p \""+sequence_results+"\"";
 			system(makedir_cmd.c_str());
 
-			//MOG2 approach
-			Ptr<BackgroundSubtractor> pMOG2 = cv::createBackgroundSubtractorMOG2();
-
-			//main loop
-			Mat img; // current Frame
-
-			int it=1;
-			acum_t=0;
-
-			for (;;) {
-
-				//get frame
-				cap >> img;
-
-				//check if we achieved the end of the file (e.g. img.data is empty)
-				if (!img.data)
-					break;
-
-
-				//Time measurement
+			//pipeline settings
+			PipelineConfig config;
+			config.connectivity = connectivity;
+			config.labeling = labeling->method;
+			config.min_width = MIN_WIDTH;
+			config.min_height = MIN_HEIGHT;
+			config.stationary = defaultStationaryParams();
+			config.learningrate = .0005; //default value (as starting point)
+			// The value between 0 and 1 that indicates how fast the background model is
+			// learnt. Negative parameter (default -1) value makes the algorithm to use some automatically chosen learning
+			// rate. 0 means that the background model is not updated at all, 1 means that the background model
+			// is completely reinitialized from the last frame.
+			config.queue_depth = queue_depth;
+			config.prefetch = prefetch;
+			config.decode_workers = decode_workers;
+			config.analysis_scale = analysis_scale;
+			config.deadline_ms = deadline_ms;
+			config.display = !headless;
+			config.classifier = models_path.empty() ? NULL : &classifier;
+			config.masks = masks;
+			config.blobs = blob_output;
+			config.record_masks = record_masks;
+			config.replay_masks = replay_masks;
+			config.title = project_name + " | Frame - FgM - Stat FgM | Blobs - Classes - Stat Classes | BlobsFil - ClassesFil - Stat ClassesFil | ("+dataset_cat[c] + "/" + baseline_seq[s] + ")";
+
+			//sweep mode: the masks of the sequence are computed once and shared by all the combinations
+			if (sweep_table)
+			{
+				std::vector<PipelineConfig> sweep_configs;
+				expandSweepGrid(sweep_grid, config, sweep_configs);
+				std::vector<SweepResult> sweep_results;
 				t = (double)getTickCount();
+				int num_masks = sweepSequence(inputvideo, sequence_results, config, sweep_configs, num_workers, sweep_results);
+				acum_t = (double)getTickCount() - t;
+				if (num_masks < 0)
+					return -1;
+				writeSweepRows(sweep_table, dataset_cat[c] + "/" + baseline_seq[s], sweep_configs, sweep_results);
+				cout << sweep_configs.size() << " combinations on " << num_masks << " masks in " << acum_t/t_freq << " seconds" << endl;
+				continue;
+			}
 
-				//apply algs
-				img.copyTo(frame);
-				// Compute fgmask
-				double learningrate=.0005; //default value (as starting point)
-				// The value between 0 and 1 that indicates how fast the background model is
-				// learnt. Negative parameter (default -1) value makes the algorithm to use some automatically chosen learning
-				// rate. 0 means that the background model is not updated at all, 1 means that the background model
-				// is completely reinitialized from the last frame.
-				pMOG2->apply(frame, fgmask, learningrate);
-				// 0 bkg, 255 fg, 127 (gray) shadows ...
-
-
-				// Extract the blobs in fgmask
-				extractBlobs(fgmask, bloblist, connectivity);
-				//		cout << "Num blobs extracted=" << bloblist.size() << endl;
-				removeSmallBlobs(bloblist, bloblistFiltered, MIN_WIDTH, MIN_HEIGHT);
-				//		cout << "Num small blobs removed=" << bloblist.size()-bloblistFiltered.size() << endl;
-
-				// Clasify the blobs in fgmask
-				classifyBlobs(bloblistFiltered);
-
-				// STATIONARY BLOBS
-				if (it==1)
-					{
-					sfgmask = Mat::zeros(Size(fgmask.cols, fgmask.rows), CV_8UC1);
-					fgmask_history = Mat::zeros(Size(fgmask.cols, fgmask.rows), CV_32FC1);
-					}
-				// Extract the STATIC blobs in fgmask
-				extractStationaryFG(fgmask, fgmask_history, sfgmask);
-				extractBlobs(sfgmask, sbloblist, connectivity);
-						//cout << "Num STATIONARY blobs extracted=" << sbloblist.size() << endl;
-				
-				removeSmallBlobs(sbloblist, sbloblistFiltered, MIN_WIDTH, MIN_HEIGHT);
-				//		cout << "Num STATIONARY small blobs removed=" << sbloblist.size()-sbloblistFiltered.size() << endl;
-
-
-				// Clasify the blobs in fgmask
-				classifyBlobs(sbloblistFiltered);
-
-		
-				//Time measurement
-				t = (double)getTickCount() - t;
-//		        if (_CONSOLE_DEBUG) cout << "proc. time = " << 1000*t/t_freq << " milliseconds."<< endl;
-				acum_t=+t;
-
-				//SHOW RESULTS
-				//get the frame number and write it on the current frame
-
-				string title= project_name + " | Frame - FgM - Stat FgM | Blobs - Classes - Stat Classes | BlobsFil - ClassesFil - Stat ClassesFil | ("+dataset_cat[c] + "/" + baseline_seq[s] + ")";
-
-				ShowManyImages(title, 6, frame, fgmask, sfgmask,
-						paintBlobImage(frame,bloblistFiltered, false), paintBlobImage(frame,bloblistFiltered, true), paintBlobImage(frame,sbloblistFiltered, true));
+			//main loop: decode, MOG2, blob analysis and display run as pipelined threads
+			t = (double)getTickCount();
+			PipelineStats stats; //latency of each stage
+			ResultsWriter results; //blobs (and masks) of every analyzed frame, written on its own thread
+			results.open(sequence_results, config.masks, config.blobs);
+			int processed;
+			if (replay_masks)
+			{
+				//masks recorded by a previous run with --record-masks
+				MaskReplay replay;
+				if (openMaskReplay(sequence_results + "/fgmask.rle", replay) < 0)
+					return -1;
+				processed = replayMasks(replay, config, stats, results.isOpened() ? &results : NULL);
+				closeMaskReplay(replay);
+			}
+			else
+			{
+				MaskRecorder recorder;
+				bool recording = record_masks && openMaskRecorder(sequence_results + "/fgmask.rle", analysis_scale, recorder) > 0;
+				processed = runPipeline(*source, config, stats, results.isOpened() ? &results : NULL, recording ? &recorder : NULL);
+				closeMaskRecorder(recorder);
+			}
+			acum_t = (double)getTickCount() - t;
+			results.close();
 
-				//exit if ESC key is pressed
-				if(waitKey(30) == 27) break;
-				it++;
-			} //main loop
+	cout << processed << "frames processed in " << 1000*acum_t/t_freq << " milliseconds."<< endl;
 
-	cout << it-1 << "frames processed in " << 1000*acum_t/t_freq << " milliseconds."<< endl;
+	//per-stage latency report (console, CSV and JSON in the results of the sequence)
+	printStats(stats);
+	writeStatsCSV(sequence_results + "/stage_latency.csv", stats);
+	writeStatsJSON(sequence_results + "/stage_latency.json", stats);
+	writeSkipLogCSV(sequence_results + "/skipped_frames.csv", stats);
+	cout << results.written() << " frames of results written, " << results.dropped() << " dropped (writer behind)" << endl;
 
 
 	//release all resources
 
-	cap.release();
-	destroyAllWindows();
-	waitKey(0); // (should stop till any key is pressed .. doesn't!!!!!)
+	source = Ptr<FrameSource>(); //stops the decoding workers
+	if (!headless) {
+		destroyAllWindows();
+		waitKey(0); // (should stop till any key is pressed .. doesn't!!!!!)
+	}
 }
 }
+if (sweep_table)
+	fclose(sweep_table);
 return 0;
 }
 
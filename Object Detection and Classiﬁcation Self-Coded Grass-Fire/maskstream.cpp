@@ -0,0 +1,285 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Recording and replay of foreground mask streams
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "maskstream.hpp"
+#include <string.h>
+
+//appends 'n' as a LEB128 varint (7 bits per byte, high bit set on all but the last)
+static inline void put_varint(std::vector<uchar> &payload, uint32_t n)
+{
+	while (n >= 0x80)
+	{
+		payload.push_back((uchar)(n | 0x80));
+		n >>= 7;
+	}
+	payload.push_back((uchar)n);
+}
+
+/**
+ *	Run-length encoding of a mask in raster order (runs continue across rows).
+ *
+ * \param mask 1-channel mask
+ * \param payload Encoded runs (appended)
+ */
+void encodeMaskRLE(const Mat &mask, std::vector<uchar> &payload)
+{
+	uchar value = 0;
+	uint32_t run = 0;
+	for (int y = 0; y < mask.rows; y++)
+	{
+		const uchar *row = mask.ptr<uchar>(y);
+		int x = 0;
+		while (x < mask.cols)
+		{
+			if (run && row[x] != value)
+			{
+				payload.push_back(value);
+				put_varint(payload, run);
+				run = 0;
+			}
+			value = row[x];
+
+			//length of the run inside this row
+			int end = x + 1;
+			while (end < mask.cols && row[end] == value)
+				end++;
+			run += (uint32_t)(end - x);
+			x = end;
+		}
+	}
+	if (run)
+	{
+		payload.push_back(value);
+		put_varint(payload, run);
+	}
+}
+
+//reads the run at 'p' (value byte and varint length). Returns false on a truncated run
+static inline bool get_run(const uchar *&p, const uchar *end, uchar &value, uint32_t &run)
+{
+	value = *p++;
+	run = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		if (p == end || shift > 28)
+			return false;
+		uchar b = *p++;
+		run |= (uint32_t)(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+}
+
+/**
+ *	Decodes the runs of encodeMaskRLE into a mask of the encoded size.
+ *
+ * \param payload Encoded runs
+ * \param bytes Size of the payload
+ * \param mask Decoded mask (already allocated, 1-channel)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int decodeMaskRLE(const uchar *payload, size_t bytes, Mat &mask)
+{
+	const uchar *p = payload, *end = payload + bytes;
+	int y = 0, x = 0;
+	while (p < end)
+	{
+		uchar value;
+		uint32_t run;
+		if (!get_run(p, end, value, run))
+			return -1;
+
+		//fill the run, row by row
+		while (run)
+		{
+			if (y >= mask.rows)
+				return -1;
+			int n = (int)std::min<uint32_t>(run, (uint32_t)(mask.cols - x));
+			memset(mask.ptr<uchar>(y) + x, value, n);
+			run -= n;
+			x += n;
+			if (x == mask.cols)
+			{
+				x = 0;
+				y++;
+			}
+		}
+	}
+	return (y == mask.rows && x == 0) ? 1 : -1;
+}
+
+/**
+ *	Creates a mask stream. The header is written with the first mask, which sets the size.
+ *
+ * \param path Stream file
+ * \param scale Analysis scale of the masks (blobs are scaled back by it on replay)
+ * \param recorder Writer state
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int openMaskRecorder(const std::string &path, int scale, MaskRecorder &recorder)
+{
+	closeMaskRecorder(recorder);
+	recorder.file = fopen(path.c_str(), "wb");
+	if (!recorder.file){
+		std::cout << "Could not create mask stream " << path << std::endl;
+		return -1;
+	}
+	recorder.size = Size();
+	recorder.scale = scale;
+
+	//return OK code
+	return 1;
+}
+
+int recordMask(MaskRecorder &recorder, int frame, const Mat &mask)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (!recorder.file || !mask.data || mask.type() != CV_8UC1 || (recorder.size.area() && mask.size() != recorder.size)){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	if (!recorder.size.area())
+	{
+		MaskStreamHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, MASKSTREAM_MAGIC, sizeof(MASKSTREAM_MAGIC));
+		header.version = MASKSTREAM_VERSION;
+		header.cols = mask.cols;
+		header.rows = mask.rows;
+		header.scale = recorder.scale;
+		fwrite(&header, sizeof(header), 1, recorder.file);
+		recorder.size = mask.size();
+	}
+
+	recorder.payload.clear();
+	encodeMaskRLE(mask, recorder.payload);
+	int32_t frame_number = frame;
+	uint32_t bytes = (uint32_t)recorder.payload.size();
+	fwrite(&frame_number, sizeof(frame_number), 1, recorder.file);
+	fwrite(&bytes, sizeof(bytes), 1, recorder.file);
+	fwrite(recorder.payload.data(), 1, bytes, recorder.file);
+
+	//return OK code
+	return 1;
+}
+
+void closeMaskRecorder(MaskRecorder &recorder)
+{
+	if (recorder.file)
+		fclose(recorder.file);
+	recorder.file = NULL;
+}
+
+/**
+ *	Opens a mask stream for replay.
+ *
+ * \param path Stream file written by a MaskRecorder
+ * \param replay Reader state (size and scale of the masks)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int openMaskReplay(const std::string &path, MaskReplay &replay)
+{
+	closeMaskReplay(replay);
+	replay.file = fopen(path.c_str(), "rb");
+	MaskStreamHeader header;
+	if (!replay.file || fread(&header, sizeof(header), 1, replay.file) != 1 ||
+		memcmp(header.magic, MASKSTREAM_MAGIC, sizeof(MASKSTREAM_MAGIC)) != 0 || header.version != MASKSTREAM_VERSION ||
+		header.cols <= 0 || header.rows <= 0){
+		std::cout << "Not a mask stream: " << path << std::endl;
+		closeMaskReplay(replay);
+		return -1;
+	}
+	replay.size = Size(header.cols, header.rows);
+	replay.scale = std::max(1, (int)header.scale);
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Checks that a payload is well formed and its runs cover exactly 'pixels' pixels, without
+ *	decoding it.
+ *
+ * \param payload Encoded runs
+ * \param bytes Size of the payload
+ * \param pixels Number of pixels of the encoded mask
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int checkMaskRLE(const uchar *payload, size_t bytes, uint64_t pixels)
+{
+	const uchar *p = payload, *end = payload + bytes;
+	uint64_t covered = 0;
+	while (p < end)
+	{
+		uchar value;
+		uint32_t run;
+		if (!get_run(p, end, value, run) || (covered += run) > pixels)
+			return -1;
+	}
+	return (covered == pixels) ? 1 : -1;
+}
+
+//reads the frame number and the payload of the next record into replay.payload
+static bool read_record(MaskReplay &replay, int32_t &frame_number)
+{
+	uint32_t bytes;
+	if (!replay.file || fread(&frame_number, sizeof(frame_number), 1, replay.file) != 1 ||
+		fread(&bytes, sizeof(bytes), 1, replay.file) != 1)
+		return false;
+
+	//the worst case is 6 bytes per pixel (a run of 1 takes the value byte and up to a 5-byte
+	//varint): a larger length is a corrupt record, not an allocation to try
+	if ((uint64_t)bytes > 6 * (uint64_t)replay.size.area()){
+		std::cout << "Corrupt mask of frame " << frame_number << std::endl;
+		return false;
+	}
+	replay.payload.resize(bytes);
+	return fread(replay.payload.data(), 1, bytes, replay.file) == bytes;
+}
+
+bool readMask(MaskReplay &replay, int &frame, Mat &mask)
+{
+	int32_t frame_number;
+	if (!read_record(replay, frame_number))
+		return false;
+
+	mask.create(replay.size, CV_8UC1);
+	if (decodeMaskRLE(replay.payload.data(), replay.payload.size(), mask) < 0){
+		std::cout << "Corrupt mask of frame " << frame_number << std::endl;
+		return false;
+	}
+	frame = frame_number;
+	return true;
+}
+
+bool readMaskRecord(MaskReplay &replay, int &frame)
+{
+	int32_t frame_number;
+	if (!read_record(replay, frame_number))
+		return false;
+
+	if (checkMaskRLE(replay.payload.data(), replay.payload.size(), (uint64_t)replay.size.area()) < 0){
+		std::cout << "Corrupt mask of frame " << frame_number << std::endl;
+		return false;
+	}
+	frame = frame_number;
+	return true;
+}
+
+void closeMaskReplay(MaskReplay &replay)
+{
+	if (replay.file)
+		fclose(replay.file);
+	replay.file = NULL;
+}
@@ -0,0 +1,96 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Recording and replay of foreground mask streams
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class MaskRecorder
+ * \brief Run-length encoded stream of the foreground masks of a sequence
+ *
+ * Recording the MOG2 masks once lets the steps after background subtraction (blob
+ * extraction, stationary detection, filtering, classification) be replayed and tuned without
+ * decoding the video nor running MOG2 again. A mask stream file is a MaskStreamHeader and
+ * one record per analyzed frame: int32 frame number, uint32 payload bytes and the payload,
+ * the mask in raster order as runs of (value byte, run length as a LEB128 varint). Masks
+ * are mostly long runs of 0, so a frame takes a few hundred bytes to a few KB.
+ */
+
+#ifndef MASKSTREAM_H_INCLUDE
+#define MASKSTREAM_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace cv;
+
+//"MASKRLE" and format version
+#define MASKSTREAM_MAGIC "MASKRLE"
+#define MASKSTREAM_VERSION 1
+
+/// Header of a mask stream file
+struct MaskStreamHeader {
+	char     magic[8];   /* MASKSTREAM_MAGIC (with its '\0')              */
+	uint32_t version;    /* MASKSTREAM_VERSION                            */
+	int32_t  cols, rows; /* mask size (analysis resolution)               */
+	int32_t  scale;      /* analysis scale of the masks (see PipelineConfig) */
+};
+
+/// Writer of a mask stream
+struct MaskRecorder {
+	FILE *file;
+	Size size;                   /* size of the masks (0x0 until the first one, which writes the header) */
+	int scale;
+	std::vector<uchar> payload;  /* encoded mask of the frame being written */
+	MaskRecorder() : file(NULL), scale(1) {}
+};
+
+/// Reader of a mask stream
+struct MaskReplay {
+	FILE *file;
+	Size size;
+	int scale;
+	std::vector<uchar> payload;  /* encoded mask of the frame being read */
+	MaskReplay() : file(NULL), scale(1) {}
+};
+
+/*
+* Headers of mask stream functions
+*
+*/
+
+//run-length encoding of a 1-channel mask (appended to 'payload') and its decoding into 'mask'
+//(which must have the size of the encoded one). Decoding returns -1 on a corrupt payload
+void encodeMaskRLE(const Mat &mask, std::vector<uchar> &payload);
+int decodeMaskRLE(const uchar *payload, size_t bytes, Mat &mask);
+
+//checks the runs of a payload (well formed, 'pixels' pixels in total) without decoding them
+int checkMaskRLE(const uchar *payload, size_t bytes, uint64_t pixels);
+
+//creates (or truncates) a mask stream for masks computed at 'scale'
+int openMaskRecorder(const std::string &path, int scale, MaskRecorder &recorder);
+
+//appends the mask of frame 'frame' (the first mask sets the size, masks of other sizes are rejected)
+int recordMask(MaskRecorder &recorder, int frame, const Mat &mask);
+
+void closeMaskRecorder(MaskRecorder &recorder);
+
+//opens a mask stream and reads its header
+int openMaskReplay(const std::string &path, MaskReplay &replay);
+
+//reads the next mask of the stream. Returns false at the end (or on a corrupt record)
+bool readMask(MaskReplay &replay, int &frame, Mat &mask);
+
+//reads and checks the next record of the stream into replay.payload, without decoding the mask
+bool readMaskRecord(MaskReplay &replay, int &frame);
+
+void closeMaskReplay(MaskReplay &replay);
+
+#endif
@@ -0,0 +1,483 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Multi-threaded frame pipeline
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "pipeline.hpp"
+#include "ShowManyImages.hpp"
+#include "results.hpp"
+#include "maskstream.hpp"
+#include <opencv2/opencv.hpp>
+
+typedef BoundedQueue<FrameData> FrameQueue;
+
+//frame at the analysis scale, downscaled into 'small' (reused between frames) if scale > 1
+static const Mat &analysisFrame(const Mat &frame, Mat &small, int scale)
+{
+	if (scale <= 1)
+		return frame;
+	//area interpolation with an integer factor averages scale x scale blocks (pyramid level)
+	resize(frame, small, Size(frame.cols / scale, frame.rows / scale), 0, 0, INTER_AREA);
+	return small;
+}
+
+//frames skipped in a row at most, so that an overloaded machine still analyzes some frames
+#define MAX_CONSECUTIVE_SKIPS 8
+
+void initRateController(RateController &rate, double deadline_ms)
+{
+	rate.deadline = deadline_ms / 1000.0;
+	rate.start = 0;
+	rate.frames = 0;
+	rate.skipped = 0;
+}
+
+/**
+ *	Rate control against a deadline per frame: frame n is due n deadlines after the first
+ *	one. A frame more than one deadline late is skipped (not analyzed), up to
+ *	MAX_CONSECUTIVE_SKIPS in a row. Frames ahead of time do not build up credit for later
+ *	ones, so only the lateness since the last frame on time counts.
+ *
+ * \param rate Controller state
+ * \param index Frame number (for the skip log)
+ * \param stats Skipped frames are appended to stats.skips
+ * \param frames_elapsed Frames since the last analyzed frame (set if the frame is analyzed)
+ *
+ * \return true if the frame has to be skipped
+ */
+bool skipFrame(RateController &rate, int index, PipelineStats &stats, int &frames_elapsed)
+{
+	int64 now = getTickCount();
+	int n = rate.frames++;
+	if (n == 0)
+		rate.start = now;
+
+	if (rate.deadline > 0)
+	{
+		double due = n * rate.deadline;
+		double late = (now - rate.start) / getTickFrequency() - due;
+		if (late < 0)
+			rate.start = now - (int64)(due * getTickFrequency()); //early: due now
+		else if (late > rate.deadline && rate.skipped < MAX_CONSECUTIVE_SKIPS)
+		{
+			rate.skipped++;
+			SkipRecord skip = { index, (float)(late * 1000) };
+			stats.skips.push_back(skip);
+			return true;
+		}
+	}
+	frames_elapsed = rate.skipped + 1;
+	rate.skipped = 0;
+	return false;
+}
+
+//stage 1: decode frames
+static void decodeStage(FrameSource &source, FrameQueue &out, PipelineStats &stats)
+{
+	for (int it = 1; ; it++)
+	{
+		FrameData data;
+		data.index = it;
+		data.skipped = false;
+		data.frames_elapsed = 1;
+		int64 t = getTickCount();
+		source.read(data.frame);
+
+		//check if we achieved the end of the file (e.g. img.data is empty)
+		if (!data.frame.data)
+			break;
+		stats.stage[STAGE_DECODE].addTicks(getTickCount() - t);
+		if (!out.push(std::move(data)))
+			break;
+	}
+	out.close();
+}
+
+//stage 2: background subtraction. Each frame is sent to the foreground and the stationary paths.
+//Frames late for the deadline are marked as skipped here and not analyzed by any stage
+static void backgroundStage(const PipelineConfig &config, FrameQueue &in, FrameQueue &out_fg, FrameQueue &out_stat, PipelineStats &stats, MaskRecorder *recorder)
+{
+	//MOG2 approach
+	Ptr<BackgroundSubtractor> pMOG2 = cv::createBackgroundSubtractorMOG2();
+	Mat small; //frame at the analysis scale
+	Mat last_fgmask;
+	RateController rate;
+	initRateController(rate, config.deadline_ms);
+
+	FrameData data;
+	while (in.pop(data))
+	{
+		data.skipped = skipFrame(rate, data.index, stats, data.frames_elapsed);
+		if (data.skipped)
+			data.fgmask = last_fgmask; //results of the last analyzed frame
+		else
+		{
+			// 0 bkg, 255 fg, 127 (gray) shadows ...
+			int64 t = getTickCount();
+			pMOG2->apply(analysisFrame(data.frame, small, config.analysis_scale), data.fgmask, config.learningrate);
+			if (recorder)
+				recordMask(*recorder, data.index, data.fgmask);
+			stats.stage[STAGE_MOG2].addTicks(getTickCount() - t);
+			last_fgmask = data.fgmask;
+		}
+		//the foreground path gets a copy (Mats are shared), the stationary path the original
+		if (!out_fg.push(data) || !out_stat.push(std::move(data)))
+			break;
+	}
+	//end of stream downstream, abort upstream if a consumer stopped
+	in.close();
+	out_fg.close();
+	out_stat.close();
+}
+
+//stage 3a: blobs of the foreground mask
+static void foregroundStage(const PipelineConfig &config, FrameQueue &in, FrameQueue &out, PipelineStats &stats)
+{
+	std::vector<cvBlob> bloblist;
+	BlobList soa;          //classifier scratch buffers
+	BlobFeatures features;
+	BlobTracker tracker; //track IDs and smoothed labels of the foreground blobs
+	initTracker(tracker);
+	std::vector<cvBlob> last_blobs; //blobs of the last analyzed frame
+	FrameData data;
+	while (in.pop(data))
+	{
+		if (data.skipped)
+		{
+			data.bloblistFiltered = last_blobs;
+			if (!out.push(std::move(data)))
+				break;
+			continue;
+		}
+
+		// Extract the blobs in fgmask
+		int64 t0 = getTickCount();
+		extractBlobs(data.fgmask, bloblist, config.connectivity, config.labeling);
+		scaleBlobs(bloblist, config.analysis_scale);
+		int64 t1 = getTickCount();
+		removeSmallBlobs(bloblist, data.bloblistFiltered, config.min_width, config.min_height);
+		int64 t2 = getTickCount();
+
+		// Clasify the blobs in fgmask
+		classifyBlobs(config.classifier, data.bloblistFiltered, soa, features);
+		int64 t3 = getTickCount();
+		trackBlobs(tracker, data.bloblistFiltered);
+		int64 t4 = getTickCount();
+
+		stats.stage[STAGE_EXTRACT_FG].addTicks(t1 - t0);
+		stats.stage[STAGE_REMOVE_FG].addTicks(t2 - t1);
+		stats.stage[STAGE_CLASSIFY_FG].addTicks(t3 - t2);
+		stats.stage[STAGE_TRACK_FG].addTicks(t4 - t3);
+		last_blobs = data.bloblistFiltered;
+
+		if (!out.push(std::move(data)))
+			break;
+	}
+	in.close();
+	out.close();
+}
+
+//stage 3b: stationary foreground mask and its blobs. Keeps the history between frames
+static void stationaryStage(const PipelineConfig &config, FrameQueue &in, FrameQueue &out, PipelineStats &stats)
+{
+	Mat fgmask_history; //started by extractStationaryFG on the first frame
+	std::vector<uchar> dirty_bands;
+	IncrementalBlobs scache; //blobs of sfgmask, only changed bands are relabeled
+	std::vector<cvBlob> sbloblist;
+	BlobList soa;          //classifier scratch buffers
+	BlobFeatures features;
+	BlobTracker stracker; //track IDs and smoothed labels of the STATIONARY blobs
+	initTracker(stracker);
+	Mat last_sfgmask; //results of the last analyzed frame
+	std::vector<cvBlob> last_sblobs;
+	FrameData data;
+	while (in.pop(data))
+	{
+		if (data.skipped)
+		{
+			data.sfgmask = last_sfgmask;
+			data.sbloblistFiltered = last_sblobs;
+			if (!out.push(std::move(data)))
+				break;
+			continue;
+		}
+
+		// Extract the STATIC blobs in fgmask (the history also counts the skipped frames)
+		int64 t0 = getTickCount();
+		extractStationaryFG(data.fgmask, fgmask_history, data.sfgmask, &dirty_bands, data.frames_elapsed, &config.stationary);
+		int64 t1 = getTickCount();
+		extractBlobsIncremental(data.sfgmask, dirty_bands, config.connectivity, scache, sbloblist, config.labeling);
+		scaleBlobs(sbloblist, config.analysis_scale);
+		int64 t2 = getTickCount();
+		removeSmallBlobs(sbloblist, data.sbloblistFiltered, config.min_width, config.min_height);
+		int64 t3 = getTickCount();
+
+		// Clasify the blobs in sfgmask
+		classifyBlobs(config.classifier, data.sbloblistFiltered, soa, features);
+		int64 t4 = getTickCount();
+		trackBlobs(stracker, data.sbloblistFiltered);
+		int64 t5 = getTickCount();
+
+		stats.stage[STAGE_STATIONARY].addTicks(t1 - t0);
+		stats.stage[STAGE_EXTRACT_STAT].addTicks(t2 - t1);
+		stats.stage[STAGE_REMOVE_STAT].addTicks(t3 - t2);
+		stats.stage[STAGE_CLASSIFY_STAT].addTicks(t4 - t3);
+		stats.stage[STAGE_TRACK_STAT].addTicks(t5 - t4);
+		last_sfgmask = data.sfgmask;
+		last_sblobs = data.sbloblistFiltered;
+
+		if (!out.push(std::move(data)))
+			break;
+	}
+	in.close();
+	out.close();
+}
+
+/**
+ *	Runs the analysis of a sequence as a pipeline of stages, each on its own thread:
+ *	decode -> background subtraction -> {foreground blobs, stationary blobs} -> rendering.
+ *	Stages are linked by BoundedQueue of 'queue_depth' frames, so a slow stage stops its
+ *	producers instead of buffering without limit, and throughput is that of the slowest
+ *	stage. Rendering runs on the calling thread (highgui must stay on the main thread).
+ *	With config.display false the rendering stage only collects the frames, so the
+ *	pipeline is not limited by drawing nor by the waitKey delay.
+ *	With config.deadline_ms > 0 the frames late for their deadline are not analyzed and
+ *	keep the results of the last analyzed frame (see skipFrame).
+ *
+ * \param source Opened frame source
+ * \param config Pipeline settings
+ * \param stats Latency of every stage and wall time of the sequence
+ * \param results Writer of the per-frame results (NULL: not written)
+ * \param recorder Stream where the foreground masks are recorded (NULL: not recorded)
+ *
+ * \return Number of frames processed
+ */
+int runPipeline(FrameSource &source, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results, MaskRecorder *recorder)
+{
+	resetStats(stats);
+	int64 start = getTickCount();
+
+	int depth = std::max(1, config.queue_depth);
+	FrameQueue decoded(depth), to_fg(depth), to_stat(depth), fg_done(depth), stat_done(depth);
+
+	std::thread decoder(decodeStage, std::ref(source), std::ref(decoded), std::ref(stats));
+	std::thread background(backgroundStage, std::cref(config), std::ref(decoded), std::ref(to_fg), std::ref(to_stat), std::ref(stats), recorder);
+	std::thread foreground(foregroundStage, std::cref(config), std::ref(to_fg), std::ref(fg_done), std::ref(stats));
+	std::thread stationary(stationaryStage, std::cref(config), std::ref(to_stat), std::ref(stat_done), std::ref(stats));
+
+	//stage 4: rendering. Both paths deliver frames in order, so their outputs are paired
+	int processed = 0;
+	FrameData fg, stat;
+	BlobOverlays overlays; //canvases reused for all the frames
+	while (fg_done.pop(fg) && stat_done.pop(stat))
+	{
+		//results of the analyzed frames are written by the writer thread
+		if (results && !fg.skipped)
+			results->push(fg.index, fg.bloblistFiltered, stat.sbloblistFiltered, fg.fgmask, stat.sfgmask);
+
+		//headless: results are only collected, nothing is drawn and no key is polled
+		if (!config.display)
+		{
+			processed++;
+			continue;
+		}
+
+		int64 t = getTickCount();
+		renderBlobOverlays(fg.frame, fg.bloblistFiltered, stat.sbloblistFiltered, overlays);
+		ShowManyImages(config.title, 6, fg.frame, fg.fgmask, stat.sfgmask,
+				overlays.unlabelled, overlays.labelled, overlays.stationary);
+		stats.stage[STAGE_RENDER].addTicks(getTickCount() - t);
+		processed++;
+
+		//exit if ESC key is pressed
+		if(waitKey(30) == 27) break;
+	}
+
+	//stop (or let finish) the upstream stages
+	fg_done.close();
+	stat_done.close();
+	decoder.join();
+	background.join();
+	foreground.join();
+	stationary.join();
+
+	stats.frames = processed;
+	stats.seconds = (getTickCount() - start) / getTickFrequency();
+	return processed;
+}
+
+/**
+ *	Analysis of a foreground mask (computed at 1/scale resolution): foreground blobs,
+ *	stationary mask and blobs, filtering, classification and tracking, with the settings of
+ *	'config'. Each stage is timed in 'stats' from 't_start'.
+ *
+ * \param analysis State kept between the masks of a sequence
+ * \param config Pipeline settings
+ * \param scale Analysis scale of the mask (blobs are reported at full resolution)
+ * \param data Frame with the mask (fgmask); gets sfgmask and the filtered blob lists
+ * \param stats Latency of every stage
+ * \param t_start Tick count at which the analysis of the mask started
+ */
+void analyzeMask(MaskAnalysis &analysis, const PipelineConfig &config, int scale, FrameData &data, PipelineStats &stats, int64 t_start)
+{
+	int64 t[8];
+	t[0] = t_start;
+	extractBlobs(data.fgmask, analysis.bloblist, config.connectivity, config.labeling);
+	scaleBlobs(analysis.bloblist, scale);
+	t[1] = getTickCount();
+	removeSmallBlobs(analysis.bloblist, data.bloblistFiltered, config.min_width, config.min_height);
+	t[2] = getTickCount();
+	classifyBlobs(config.classifier, data.bloblistFiltered, analysis.soa, analysis.features);
+	t[3] = getTickCount();
+
+	extractStationaryFG(data.fgmask, analysis.fgmask_history, data.sfgmask, &analysis.dirty_bands, data.frames_elapsed, &config.stationary);
+	t[4] = getTickCount();
+	extractBlobsIncremental(data.sfgmask, analysis.dirty_bands, config.connectivity, analysis.scache, analysis.sbloblist, config.labeling);
+	scaleBlobs(analysis.sbloblist, scale);
+	t[5] = getTickCount();
+	removeSmallBlobs(analysis.sbloblist, data.sbloblistFiltered, config.min_width, config.min_height);
+	t[6] = getTickCount();
+	classifyBlobs(config.classifier, data.sbloblistFiltered, analysis.soa, analysis.features);
+	t[7] = getTickCount();
+
+	//stages STAGE_EXTRACT_FG..STAGE_CLASSIFY_STAT run in this order
+	for (int s = STAGE_EXTRACT_FG; s <= STAGE_CLASSIFY_STAT; s++)
+		stats.stage[s].addTicks(t[s-STAGE_EXTRACT_FG+1] - t[s-STAGE_EXTRACT_FG]);
+
+	trackBlobs(analysis.tracker, data.bloblistFiltered);
+	int64 t_track = getTickCount();
+	trackBlobs(analysis.stracker, data.sbloblistFiltered);
+	stats.stage[STAGE_TRACK_FG].addTicks(t_track - t[7]);
+	stats.stage[STAGE_TRACK_STAT].addTicks(getTickCount() - t_track);
+}
+
+/**
+ *	Runs the analysis of a sequence on the calling thread and without display: decode,
+ *	background subtraction, foreground and stationary blobs for every frame. All the state
+ *	(MOG2 model and stationary history) is local, so several sequences can be analyzed at
+ *	the same time on different threads. Frames are skipped against config.deadline_ms as
+ *	in runPipeline.
+ *
+ * \param source Opened frame source
+ * \param config Pipeline settings (title and queue_depth are not used)
+ * \param stats Latency of every stage and wall time of the sequence
+ * \param results Writer of the per-frame results (NULL: not written)
+ * \param recorder Stream where the foreground masks are recorded (NULL: not recorded)
+ *
+ * \return Number of frames processed
+ */
+int analyzeSequence(FrameSource &source, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results, MaskRecorder *recorder)
+{
+	resetStats(stats);
+	int64 start = getTickCount();
+
+	//MOG2 approach
+	Ptr<BackgroundSubtractor> pMOG2 = cv::createBackgroundSubtractorMOG2();
+	Mat small; //frame at the analysis scale
+	MaskAnalysis analysis;
+	initTracker(analysis.tracker);
+	initTracker(analysis.stracker);
+	RateController rate;
+	initRateController(rate, config.deadline_ms);
+	FrameData data;
+
+	int processed = 0;
+	for (;;)
+	{
+		int64 t[3];
+		t[0] = getTickCount();
+		source.read(data.frame);
+		t[1] = getTickCount();
+		if (!data.frame.data)
+			break;
+		data.index = processed + 1;
+		stats.stage[STAGE_DECODE].addTicks(t[1] - t[0]);
+
+		//late frames keep the masks and blobs of the last analyzed frame
+		data.skipped = skipFrame(rate, data.index, stats, data.frames_elapsed);
+		if (data.skipped)
+		{
+			processed++;
+			continue;
+		}
+
+		pMOG2->apply(analysisFrame(data.frame, small, config.analysis_scale), data.fgmask, config.learningrate);
+		if (recorder)
+			recordMask(*recorder, data.index, data.fgmask);
+		t[2] = getTickCount();
+		stats.stage[STAGE_MOG2].addTicks(t[2] - t[1]);
+
+		analyzeMask(analysis, config, config.analysis_scale, data, stats, t[2]);
+
+		if (results)
+			results->push(data.index, data.bloblistFiltered, data.sbloblistFiltered, data.fgmask, data.sfgmask);
+		processed++;
+	}
+	stats.frames = processed;
+	stats.seconds = (getTickCount() - start) / getTickFrequency();
+	return processed;
+}
+
+/**
+ *	Runs the analysis after background subtraction on the masks of a recorded stream, so
+ *	that blob extraction, stationary detection, filtering and classification can be tuned
+ *	without decoding the video nor running MOG2: the speed is that of the post-processing
+ *	alone. Masks keep the analysis scale they were recorded at (config.analysis_scale is
+ *	not used) and the frames skipped while recording are accounted for in the stationary
+ *	history. STAGE_DECODE is the time to read and decode the masks.
+ *
+ * \param replay Opened mask stream
+ * \param config Pipeline settings (as in analyzeSequence)
+ * \param stats Latency of every stage and wall time of the replay
+ * \param results Writer of the per-frame results (NULL: not written)
+ *
+ * \return Number of masks processed
+ */
+int replayMasks(MaskReplay &replay, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results)
+{
+	resetStats(stats);
+	int64 start = getTickCount();
+
+	MaskAnalysis analysis;
+	initTracker(analysis.tracker);
+	initTracker(analysis.stracker);
+	FrameData data;
+	data.skipped = false;
+
+	int processed = 0, last_index = 0;
+	for (;;)
+	{
+		int64 t0 = getTickCount();
+		if (!readMask(replay, data.index, data.fgmask))
+			break;
+		int64 t1 = getTickCount();
+		stats.stage[STAGE_DECODE].addTicks(t1 - t0);
+		data.frames_elapsed = last_index ? std::max(1, data.index - last_index) : 1;
+		last_index = data.index;
+
+		analyzeMask(analysis, config, replay.scale, data, stats, t1);
+
+		if (results)
+			results->push(data.index, data.bloblistFiltered, data.sbloblistFiltered, data.fgmask, data.sfgmask);
+		processed++;
+	}
+	stats.frames = processed;
+	stats.seconds = (getTickCount() - start) / getTickFrequency();
+	return processed;
+}
+
+int runPipeline(VideoCapture &cap, const PipelineConfig &config, PipelineStats &stats)
+{
+	VideoSource source(cap);
+	return runPipeline(source, config, stats);
+}
+
+int analyzeSequence(VideoCapture &cap, const PipelineConfig &config, PipelineStats &stats)
+{
+	VideoSource source(cap);
+	return analyzeSequence(source, config, stats);
+}
@@ -0,0 +1,233 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Multi-threaded frame pipeline
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class BoundedQueue
+ * \brief Bounded lock-free single-producer/single-consumer queue linking two pipeline stages
+ *
+ * push() waits while the queue is full (backpressure) and pop() waits while it is empty;
+ * tryPush() and tryPop() fail instead of waiting, for sides that must never block.
+ * Either side may close() the queue: the producer to signal the end of the stream and the
+ * consumer to abort it. After close() push() fails and pop() fails once the queue is drained.
+ */
+
+#ifndef PIPELINE_H_INCLUDE
+#define PIPELINE_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "blobs.hpp"
+#include "tracker.hpp"
+#include "classifier.hpp"
+#include "stats.hpp"
+#include "framesource.hpp"
+
+template<typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(int depth) : slots(depth + 1), head(0), tail(0), closed(false) {}
+
+	//add an item (moved into its slot), waiting while the queue is full. Returns false if
+	//the queue was closed
+	bool push(T item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) % slots.size();
+		for (int spins = 0; next == head.load(std::memory_order_acquire); spins++)
+		{
+			if (closed.load(std::memory_order_acquire))
+				return false;
+			wait(spins);
+		}
+		if (closed.load(std::memory_order_acquire))
+			return false;
+		slots[t] = std::move(item);
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	//add an item without waiting. Returns false (and keeps the item) if the queue is full or closed
+	bool tryPush(T &item)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t next = (t + 1) % slots.size();
+		if (next == head.load(std::memory_order_acquire) || closed.load(std::memory_order_acquire))
+			return false;
+		slots[t] = std::move(item);
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	//true if a push would have to wait. Only meaningful on the producer side: the consumer
+	//can only free slots, so the queue stays not full until the producer pushes
+	bool full() const
+	{
+		size_t next = (tail.load(std::memory_order_relaxed) + 1) % slots.size();
+		return next == head.load(std::memory_order_acquire);
+	}
+
+	//take the oldest item, waiting while the queue is empty. Returns false if the queue
+	//was closed and there is nothing left
+	bool pop(T &item)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		for (int spins = 0; h == tail.load(std::memory_order_acquire); spins++)
+		{
+			if (closed.load(std::memory_order_acquire) && h == tail.load(std::memory_order_acquire))
+				return false;
+			wait(spins);
+		}
+		item = std::move(slots[h]);
+		slots[h] = T(); //release anything left in the slot
+		head.store((h + 1) % slots.size(), std::memory_order_release);
+		return true;
+	}
+
+	//take the oldest item without waiting. Returns false if the queue is empty
+	bool tryPop(T &item)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+		item = std::move(slots[h]);
+		slots[h] = T();
+		head.store((h + 1) % slots.size(), std::memory_order_release);
+		return true;
+	}
+
+	void close() { closed.store(true, std::memory_order_release); }
+
+private:
+	//spin briefly, then yield, then sleep so that idle stages do not burn a core
+	static void wait(int spins)
+	{
+		if (spins < 64)
+			return;
+		if (spins < 128)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	std::vector<T> slots;
+	std::atomic<size_t> head; //next slot to read (consumer)
+	std::atomic<size_t> tail; //next slot to write (producer)
+	std::atomic<bool> closed;
+};
+
+class ResultsWriter; //see results.hpp
+struct MaskRecorder;  //see maskstream.hpp
+struct MaskReplay;
+
+/// Data of one frame travelling through the pipeline
+struct FrameData {
+	int index;                                  /* frame number (from 1)              */
+	bool skipped;                               /* not analyzed (results of the last analyzed frame) */
+	int frames_elapsed;                         /* frames since the last analyzed frame */
+	Mat frame;                                  /* decoded frame                      */
+	Mat fgmask;                                 /* foreground mask (analysis scale)   */
+	Mat sfgmask;                                /* STATIONARY foreground mask (analysis scale) */
+	std::vector<cvBlob> bloblistFiltered;       /* filtered and classified blobs      */
+	std::vector<cvBlob> sbloblistFiltered;      /* filtered and classified STATIONARY blobs */
+};
+
+/// Deadline-based frame skipping: frame n is due n deadlines after the first one
+struct RateController {
+	double deadline;         /* seconds per frame (0: never skip)          */
+	int64 start;             /* tick at which the first frame was due      */
+	int frames;              /* frames seen                                */
+	int skipped;             /* frames skipped since the last analyzed one */
+};
+
+/// Output of the foreground masks with the results (see ResultsWriter)
+typedef enum {
+	MASKS_NONE=0,  /* blobs only                        */
+	MASKS_PNG=1,   /* one PNG per frame and mask        */
+	MASKS_RAW=2    /* uncompressed, one file per mask   */
+} MASK_OUTPUT;
+
+/// Format of the per-frame blobs written with the results (see ResultsWriter)
+typedef enum {
+	BLOBS_CSV=0,   /* blobs.csv, one text line per blob             */
+	BLOBS_LOG=1    /* blobs.log, binary log (see BlobLogReader)     */
+} BLOB_OUTPUT;
+
+/// Settings of the pipeline for one sequence
+struct PipelineConfig {
+	int connectivity;        /* 4 or 8                                     */
+	LABELING labeling;       /* labeling backend of extractBlobs           */
+	int min_width;           /* removeSmallBlobs limits                    */
+	int min_height;
+	StationaryParams stationary; /* extractStationaryFG parameters         */
+	double learningrate;     /* MOG2 learning rate                         */
+	int queue_depth;         /* frames buffered between consecutive stages */
+	int prefetch;            /* image sequences: frames decoded ahead (0: decode on read) */
+	int decode_workers;      /* image sequences: decoding threads (0: one per core) */
+	int analysis_scale;      /* 1, 2, 4 or 8: masks and blobs are computed at 1/scale resolution */
+	double deadline_ms;      /* time budget per frame, late frames are skipped (0: never skip) */
+	bool display;            /* false: headless, nothing is rendered       */
+	const BlobClassifier *classifier; /* class models (NULL: built-in models) */
+	MASK_OUTPUT masks;       /* masks written with the per-frame results   */
+	BLOB_OUTPUT blobs;       /* format of the per-frame blobs              */
+	bool record_masks;       /* foreground masks recorded to <results>/fgmask.rle */
+	bool replay_masks;       /* <results>/fgmask.rle replayed instead of the input (see replayMasks) */
+	std::string title;       /* window title                               */
+};
+
+/*
+* Headers of pipeline functions
+*
+*/
+
+//starts the rate controller with a deadline per frame in milliseconds (0: never skip)
+void initRateController(RateController &rate, double deadline_ms);
+
+//decides if a frame has to be skipped to catch up with the deadline and logs the skips in
+//'stats'. For analyzed frames 'frames_elapsed' is set to the frames since the last analyzed one
+bool skipFrame(RateController &rate, int index, PipelineStats &stats, int &frames_elapsed);
+
+//runs decode, background subtraction, foreground and stationary blob analysis and rendering
+//(if config.display) on separate threads for all the frames of 'source'. The results of the
+//analyzed frames are queued to 'results' and their masks recorded to 'recorder' if given.
+//Returns the number of frames processed
+int runPipeline(FrameSource &source, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results=NULL, MaskRecorder *recorder=NULL);
+int runPipeline(VideoCapture &cap, const PipelineConfig &config, PipelineStats &stats);
+
+//runs the same analysis on the calling thread without display. Returns the number of frames processed
+int analyzeSequence(FrameSource &source, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results=NULL, MaskRecorder *recorder=NULL);
+int analyzeSequence(VideoCapture &cap, const PipelineConfig &config, PipelineStats &stats);
+
+/// State of the analysis of a sequence after background subtraction (see analyzeMask)
+struct MaskAnalysis {
+	Mat fgmask_history; //started by extractStationaryFG on the first frame
+	std::vector<uchar> dirty_bands;
+	IncrementalBlobs scache; //blobs of sfgmask, only changed bands are relabeled
+	std::vector<cvBlob> bloblist, sbloblist;
+	BlobList soa;          //classifier scratch buffers
+	BlobFeatures features;
+	BlobTracker tracker, stracker; //foreground and STATIONARY tracks
+};
+
+//foreground and stationary blobs of data.fgmask (computed at 1/scale resolution): extraction,
+//filtering, classification and tracking. Stages are timed from 't_start'
+void analyzeMask(MaskAnalysis &analysis, const PipelineConfig &config, int scale, FrameData &data, PipelineStats &stats, int64 t_start);
+
+//runs the analysis after background subtraction on recorded masks (no decoding nor MOG2).
+//Returns the number of masks processed
+int replayMasks(MaskReplay &replay, const PipelineConfig &config, PipelineStats &stats, ResultsWriter *results=NULL);
+
+#endif
@@ -0,0 +1,82 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Offline query of a binary blob log
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+//system libraries C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+
+//include for the blob log
+#include "bloblog.hpp"
+
+//namespaces
+using namespace std;
+
+//number of values of CLASS
+#define NUM_LABELS (OBJECT + 1)
+
+int main(int argc, char ** argv)
+{
+	//usage: query_bloblog <blobs.log> [first [last]] [--count]
+	//	without frames: summary of the log
+	//	first [last]:   CSV of the blobs of frames first..last (default last = first)
+	//	--count:        blobs per class of the range instead of the CSV
+	if (argc < 2) {
+		cout << "Usage: " << argv[0] << " <blobs.log> [first [last]] [--count]" << endl;
+		return -1;
+	}
+	bool count_only = false;
+	int first = -1, last = -1;
+	for (int a = 2; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "--count")
+			count_only = true;
+		else if (first < 0)
+			first = last = atoi(argv[a]);
+		else
+			last = atoi(argv[a]);
+	}
+
+	BlobLogReader log;
+	if (!log.open(argv[1]))
+		return -1;
+
+	if (first < 0)
+	{
+		int end = log.firstFrame() + log.numFrames() - 1;
+		printf("frames %d..%d (%d), blobs %zu\n", log.firstFrame(), end, log.numFrames(), log.numRecords());
+		if (log.numFrames())
+			printf("time %.3f..%.3f\n", log.frame(log.firstFrame())->timestamp, log.frame(end)->timestamp);
+		return 0;
+	}
+
+	size_t n;
+	const BlobRecord *r = log.range(first, last, n);
+	if (count_only)
+	{
+		size_t counts[2][NUM_LABELS] = {{0}};
+		for (size_t i = 0; i < n; i++)
+			if (r[i].label >= 0 && r[i].label < NUM_LABELS)
+				counts[r[i].type == BLOB_STATIONARY][r[i].label]++;
+		static const char *names[NUM_LABELS] = { "UNKNOWN", "PERSON", "GROUP", "CAR", "OBJECT" };
+		printf("class,fg,stationary\n");
+		for (int c = 0; c < NUM_LABELS; c++)
+			printf("%s,%zu,%zu\n", names[c], counts[0][c], counts[1][c]);
+		return 0;
+	}
+
+	printf("frame,timestamp,type,ID,x,y,w,h,label,area,cx,cy,fill\n");
+	for (size_t i = 0; i < n; i++)
+		printf("%d,%.3f,%s,%d,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.4f\n", r[i].frame, log.frame(r[i].frame)->timestamp,
+				r[i].type == BLOB_STATIONARY ? "stationary" : "fg", r[i].ID, r[i].x, r[i].y, r[i].w, r[i].h,
+				r[i].label, r[i].area, r[i].cx, r[i].cy, r[i].fill);
+	return 0;
+}
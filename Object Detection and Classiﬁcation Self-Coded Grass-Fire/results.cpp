@@ -0,0 +1,221 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Asynchronous writer of the per-frame results
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "results.hpp"
+#include <stdint.h>
+#include <chrono>
+
+ResultsWriter::ResultsWriter()
+	: queue(NULL), masks(MASKS_NONE), blobs(BLOBS_CSV), batch(1), blobs_file(NULL), fgmask_file(NULL), sfgmask_file(NULL),
+	  frames_written(0), frames_dropped(0)
+{
+}
+
+ResultsWriter::~ResultsWriter()
+{
+	close();
+}
+
+/**
+ *	Creates the result files of a sequence and starts the writer thread.
+ *
+ * \param dir Results directory of the sequence (must exist)
+ * \param masks Output of the foreground masks (see MASK_OUTPUT)
+ * \param blobs Format of the blobs (see BLOB_OUTPUT)
+ * \param depth Frames that can wait to be written; more are dropped
+ * \param batch Frames written per flush
+ *
+ * \return true if the files could be created
+ */
+bool ResultsWriter::open(const std::string &dir, MASK_OUTPUT masks, BLOB_OUTPUT blobs, int depth, int batch)
+{
+	close();
+	this->dir = dir;
+	this->masks = masks;
+	this->blobs = blobs;
+	this->batch = std::max(1, batch);
+	frames_written = 0;
+	frames_dropped = 0;
+
+	if (blobs == BLOBS_LOG)
+	{
+		if (openBlobLog(dir + "/blobs.log", blob_log) < 0)
+			return false;
+	}
+	else
+	{
+		blobs_file = fopen((dir + "/blobs.csv").c_str(), "w");
+		if (!blobs_file){
+			std::cout << "Could not create " << dir << "/blobs.csv" << std::endl;
+			return false;
+		}
+		fprintf(blobs_file, "frame,type,ID,x,y,w,h,label,area,cx,cy,fill\n");
+	}
+
+	if (masks == MASKS_PNG)
+	{
+		std::string makedir_cmd = "mkdir -p \"" + dir + "/fgmask\" \"" + dir + "/sfgmask\"";
+		if (system(makedir_cmd.c_str()) != 0){
+			std::cout << "Could not create the mask directories in " << dir << std::endl;
+			close();
+			return false;
+		}
+	}
+	else if (masks == MASKS_RAW)
+	{
+		fgmask_file = fopen((dir + "/fgmask.raw").c_str(), "wb");
+		sfgmask_file = fopen((dir + "/sfgmask.raw").c_str(), "wb");
+		if (!fgmask_file || !sfgmask_file){
+			std::cout << "Could not create the raw mask files in " << dir << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	queue = new BoundedQueue<ResultItem>(std::max(1, depth));
+	writer = std::thread(&ResultsWriter::run, this);
+	return true;
+}
+
+/**
+ *	Queues the results of a frame. Only moves data into the queue (blob lists are copied,
+ *	masks cloned since the pipeline reuses their buffers), so it never waits for disk: if the
+ *	writer is behind and the queue is full the frame is dropped and counted in dropped(),
+ *	before anything is copied. Must be called from a single thread.
+ */
+void ResultsWriter::push(int index, const std::vector<cvBlob> &blobs, const std::vector<cvBlob> &sblobs, const Mat &fgmask, const Mat &sfgmask)
+{
+	if (!queue)
+		return;
+	if (queue->full())
+	{
+		frames_dropped++;
+		return;
+	}
+
+	ResultItem item;
+	item.index = index;
+	item.timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+	item.blobs = blobs;
+	item.sblobs = sblobs;
+	if (masks != MASKS_NONE)
+	{
+		item.fgmask = fgmask.clone();
+		item.sfgmask = sfgmask.clone();
+	}
+	if (!queue->tryPush(item))
+		frames_dropped++;
+}
+
+void ResultsWriter::close()
+{
+	if (queue)
+	{
+		queue->close();
+		if (writer.joinable())
+			writer.join();
+		delete queue;
+		queue = NULL;
+	}
+	closeBlobLog(blob_log);
+	if (blobs_file)
+		fclose(blobs_file);
+	if (fgmask_file)
+		fclose(fgmask_file);
+	if (sfgmask_file)
+		fclose(sfgmask_file);
+	blobs_file = fgmask_file = sfgmask_file = NULL;
+}
+
+//writer thread: waits for a frame, takes the others already queued (up to 'batch') and writes them
+void ResultsWriter::run()
+{
+	std::vector<ResultItem> items;
+	ResultItem item;
+	while (queue->pop(item))
+	{
+		items.push_back(std::move(item));
+		while ((int)items.size() < batch && queue->tryPop(item))
+			items.push_back(std::move(item));
+		writeBatch(items);
+		items.clear();
+	}
+}
+
+//CSV lines of a blob list
+static void appendBlobs(std::string &text, int index, const char *type, const std::vector<cvBlob> &bloblist)
+{
+	char line[256];
+	for (size_t i = 0; i < bloblist.size(); i++)
+	{
+		const cvBlob &b = bloblist[i];
+		snprintf(line, sizeof(line), "%d,%s,%d,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.4f\n", index, type, b.ID, b.x, b.y, b.w, b.h,
+				(int)b.label, b.area, b.cx, b.cy, b.fill);
+		text += line;
+	}
+}
+
+//one record of a raw mask file: frame, rows and cols (int32) and the mask bytes, row by row
+static void appendRawMask(FILE *file, int index, const Mat &mask)
+{
+	int32_t header[3] = { index, mask.rows, mask.cols };
+	fwrite(header, sizeof(int32_t), 3, file);
+	if (mask.isContinuous())
+		fwrite(mask.data, 1, mask.total() * mask.elemSize(), file);
+	else
+		for (int y = 0; y < mask.rows; y++)
+			fwrite(mask.ptr(y), 1, mask.cols * mask.elemSize(), file);
+}
+
+//writes the blobs of a batch (CSV with a single write call) and then its masks
+void ResultsWriter::writeBatch(std::vector<ResultItem> &items)
+{
+	if (blobs == BLOBS_LOG)
+	{
+		for (size_t i = 0; i < items.size(); i++)
+			appendBlobLog(blob_log, items[i].index, items[i].timestamp, items[i].blobs, items[i].sblobs);
+		flushBlobLog(blob_log);
+	}
+	else
+	{
+		text.clear();
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			appendBlobs(text, items[i].index, "fg", items[i].blobs);
+			appendBlobs(text, items[i].index, "stationary", items[i].sblobs);
+		}
+		fwrite(text.data(), 1, text.size(), blobs_file);
+		fflush(blobs_file);
+	}
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		const ResultItem &r = items[i];
+		if (masks == MASKS_PNG)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "/%06d.png", r.index);
+			if (r.fgmask.data)
+				imwrite(dir + "/fgmask" + name, r.fgmask);
+			if (r.sfgmask.data)
+				imwrite(dir + "/sfgmask" + name, r.sfgmask);
+		}
+		else if (masks == MASKS_RAW)
+		{
+			appendRawMask(fgmask_file, r.index, r.fgmask);
+			appendRawMask(sfgmask_file, r.index, r.sfgmask);
+		}
+	}
+	if (masks == MASKS_RAW)
+	{
+		fflush(fgmask_file);
+		fflush(sfgmask_file);
+	}
+	frames_written += (long)items.size();
+}
@@ -0,0 +1,90 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Asynchronous writer of the per-frame results
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class ResultsWriter
+ * \brief Results sink drained by a background thread, so the analysis never waits for disk
+ *
+ * The analysis thread hands every analyzed frame to push(), which only moves it into a
+ * bounded queue: if the queue is full the frame is dropped and counted, never waited for.
+ * The writer thread takes the queued frames in batches and writes, in the results directory:
+ *
+ *	blobs.csv     with BLOBS_CSV: one line per filtered blob: frame,type,ID,x,y,w,h,label,
+ *	              area,cx,cy,fill (type fg or stationary)
+ *	blobs.log     with BLOBS_LOG: the same blobs in a binary log (see BlobLogReader)
+ *	fgmask/, sfgmask/   with MASKS_PNG: one PNG per frame (NNNNNN.png)
+ *	fgmask.raw, sfgmask.raw   with MASKS_RAW: every frame appended as a record of three
+ *	              int32 (frame, rows, cols) followed by rows*cols bytes
+ *
+ * Masks are those of the analysis (see PipelineConfig.analysis_scale).
+ */
+
+#ifndef RESULTS_H_INCLUDE
+#define RESULTS_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "blobs.hpp"
+#include "pipeline.hpp"
+#include "bloblog.hpp"
+
+/// Results of one frame waiting to be written
+struct ResultItem {
+	int index;                        /* frame number (from 1) */
+	double timestamp;                 /* time it was queued (seconds since the epoch) */
+	std::vector<cvBlob> blobs;        /* filtered blobs        */
+	std::vector<cvBlob> sblobs;       /* filtered STATIONARY blobs */
+	Mat fgmask, sfgmask;              /* empty with MASKS_NONE */
+};
+
+class ResultsWriter
+{
+public:
+	ResultsWriter();
+	~ResultsWriter();
+
+	//creates the output files in 'dir' and starts the writer thread. 'depth' frames can wait
+	//in the queue and up to 'batch' frames are written per flush
+	bool open(const std::string &dir, MASK_OUTPUT masks=MASKS_NONE, BLOB_OUTPUT blobs=BLOBS_CSV, int depth=64, int batch=16);
+	bool isOpened() const { return writer.joinable(); }
+
+	//queues the results of an analyzed frame without waiting (dropped if the queue is full)
+	void push(int index, const std::vector<cvBlob> &blobs, const std::vector<cvBlob> &sblobs, const Mat &fgmask, const Mat &sfgmask);
+
+	//writes everything still queued and stops the writer thread
+	void close();
+
+	long written() const { return frames_written.load(); }
+	long dropped() const { return frames_dropped.load(); }
+
+private:
+	void run();
+	void writeBatch(std::vector<ResultItem> &items);
+
+	BoundedQueue<ResultItem> *queue;
+	std::thread writer;
+	std::string dir;
+	MASK_OUTPUT masks;
+	BLOB_OUTPUT blobs;
+	int batch;
+	FILE *blobs_file;                  /* BLOBS_CSV */
+	BlobLogWriter blob_log;            /* BLOBS_LOG */
+	FILE *fgmask_file, *sfgmask_file;  /* MASKS_RAW */
+	std::string text;                  /* CSV lines of the current batch */
+	std::atomic<long> frames_written;
+	std::atomic<long> frames_dropped;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Per-stage latency statistics
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "stats.hpp"
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <string.h>
+
+void LatencyHistogram::reset()
+{
+	memset(counts, 0, sizeof(counts));
+	total = sum = maximum = 0;
+}
+
+//values below HIST_SUB_BUCKETS have their own bucket. Above, the bucket is given by the
+//position of the highest bit (group) and the HIST_SUB_BITS bits that follow it
+int LatencyHistogram::bucketOf(uint64_t ns)
+{
+	if (ns < (uint64_t)HIST_SUB_BUCKETS)
+		return (int)ns;
+	int msb = 63 - __builtin_clzll(ns);
+	int group = msb - HIST_SUB_BITS + 1;
+	int sub = (int)((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+	return group * HIST_SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket)
+{
+	if (bucket < HIST_SUB_BUCKETS)
+		return (uint64_t)bucket;
+	int group = bucket / HIST_SUB_BUCKETS;
+	int sub = bucket % HIST_SUB_BUCKETS;
+	int shift = group - 1;
+	return (((uint64_t)(HIST_SUB_BUCKETS + sub + 1)) << shift) - 1;
+}
+
+void LatencyHistogram::add(uint64_t ns)
+{
+	counts[bucketOf(ns)]++;
+	total++;
+	sum += ns;
+	if (ns > maximum)
+		maximum = ns;
+}
+
+void LatencyHistogram::addTicks(int64 ticks)
+{
+	static const double ns_per_tick = 1e9 / cv::getTickFrequency();
+	add(ticks > 0 ? (uint64_t)(ticks * ns_per_tick) : 0);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+	if (!total)
+		return 0;
+	uint64_t rank = (uint64_t)(p * total);
+	if (rank >= total)
+		rank = total - 1;
+
+	uint64_t seen = 0;
+	for (int b = 0; b < HIST_BUCKETS; b++)
+	{
+		seen += counts[b];
+		if (seen > rank)
+			return std::min(bucketUpperBound(b), maximum);
+	}
+	return maximum;
+}
+
+const char *stageName(int stage)
+{
+	static const char *names[NUM_STAGES] = {
+		"decode", "mog2", "extractBlobs", "removeSmallBlobs", "classifyBlobs",
+		"extractStationaryFG", "extractBlobs_stationary", "removeSmallBlobs_stationary", "classifyBlobs_stationary",
+		"render", "trackBlobs", "trackBlobs_stationary"
+	};
+	return (stage >= 0 && stage < NUM_STAGES) ? names[stage] : "unknown";
+}
+
+void resetStats(PipelineStats &stats)
+{
+	for (int s = 0; s < NUM_STAGES; s++)
+		stats.stage[s].reset();
+	stats.frames = 0;
+	stats.seconds = 0;
+	stats.skips.clear();
+}
+
+/**
+ *	Prints the latency of every stage that ran at least once (count, mean, p50, p95, p99
+ *	and max in milliseconds) and the frames per second of the sequence.
+ *
+ * \param stats Timing of the sequence
+ */
+void printStats(const PipelineStats &stats)
+{
+	printf("%-28s %8s %9s %9s %9s %9s %9s\n", "stage (ms)", "count", "mean", "p50", "p95", "p99", "max");
+	for (int s = 0; s < NUM_STAGES; s++)
+	{
+		const LatencyHistogram &h = stats.stage[s];
+		if (!h.count())
+			continue;
+		printf("%-28s %8llu %9.3f %9.3f %9.3f %9.3f %9.3f\n", stageName(s), (unsigned long long)h.count(),
+				h.mean()/1e6, h.percentile(0.50)/1e6, h.percentile(0.95)/1e6, h.percentile(0.99)/1e6, h.max()/1e6);
+	}
+	printf("%d frames in %.3f s (%.2f fps)\n", stats.frames, stats.seconds, stats.seconds > 0 ? stats.frames/stats.seconds : 0);
+	if (!stats.skips.empty())
+		printf("%d frames skipped to meet the deadline\n", (int)stats.skips.size());
+}
+
+/**
+ *	Writes the latency of every stage as CSV, one row per stage with count, mean, p50,
+ *	p95, p99 and max in milliseconds.
+ *
+ * \param path Output file
+ * \param stats Timing of the sequence
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int writeStatsCSV(const std::string &path, const PipelineStats &stats)
+{
+	std::ofstream out(path.c_str());
+	if (!out.is_open())
+		return -1;
+
+	out << "stage,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms" << std::endl;
+	for (int s = 0; s < NUM_STAGES; s++)
+	{
+		const LatencyHistogram &h = stats.stage[s];
+		out << stageName(s) << "," << h.count() << "," << h.mean()/1e6 << "," << h.percentile(0.50)/1e6 << ","
+			<< h.percentile(0.95)/1e6 << "," << h.percentile(0.99)/1e6 << "," << h.max()/1e6 << std::endl;
+	}
+	return 1;
+}
+
+/**
+ *	Writes the frames, wall time, frames per second and the latency of every stage as JSON.
+ *
+ * \param path Output file
+ * \param stats Timing of the sequence
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int writeStatsJSON(const std::string &path, const PipelineStats &stats)
+{
+	std::ofstream out(path.c_str());
+	if (!out.is_open())
+		return -1;
+
+	out << "{\n  \"frames\": " << stats.frames << ",\n  \"seconds\": " << stats.seconds
+		<< ",\n  \"fps\": " << (stats.seconds > 0 ? stats.frames/stats.seconds : 0) << ",\n  \"stages\": {";
+	for (int s = 0; s < NUM_STAGES; s++)
+	{
+		const LatencyHistogram &h = stats.stage[s];
+		out << (s ? "," : "") << "\n    \"" << stageName(s) << "\": {\"count\": " << h.count() << ", \"mean_ms\": " << h.mean()/1e6
+			<< ", \"p50_ms\": " << h.percentile(0.50)/1e6 << ", \"p95_ms\": " << h.percentile(0.95)/1e6
+			<< ", \"p99_ms\": " << h.percentile(0.99)/1e6 << ", \"max_ms\": " << h.max()/1e6 << "}";
+	}
+	out << "\n  },\n  \"skipped\": [";
+	for (size_t k = 0; k < stats.skips.size(); k++)
+		out << (k ? ", " : "") << "{\"frame\": " << stats.skips[k].frame << ", \"late_ms\": " << stats.skips[k].late_ms << "}";
+	out << "]\n}" << std::endl;
+	return 1;
+}
+
+/**
+ *	Writes the skip decisions of the rate controller as CSV, one row per skipped frame with
+ *	its number and how late it was (milliseconds).
+ *
+ * \param path Output file
+ * \param stats Timing of the sequence
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int writeSkipLogCSV(const std::string &path, const PipelineStats &stats)
+{
+	std::ofstream out(path.c_str());
+	if (!out.is_open())
+		return -1;
+
+	out << "frame,late_ms" << std::endl;
+	for (size_t k = 0; k < stats.skips.size(); k++)
+		out << stats.skips[k].frame << "," << stats.skips[k].late_ms << std::endl;
+	return 1;
+}
@@ -0,0 +1,112 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Per-stage latency statistics
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class LatencyHistogram
+ * \brief Log-linear latency histogram with O(1) insertion and bounded relative error
+ *
+ * Latencies are stored in nanoseconds. Each power of two is split in HIST_SUB_BUCKETS
+ * linear buckets, so a percentile is reported with an error below 1/HIST_SUB_BUCKETS
+ * of its value. The maximum, count and sum are exact.
+ */
+
+#ifndef STATS_H_INCLUDE
+#define STATS_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Linear buckets per power of two (must be a power of two)
+const int HIST_SUB_BITS = 4;
+const int HIST_SUB_BUCKETS = 1 << HIST_SUB_BITS;
+const int HIST_BUCKETS = (64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS;
+
+class LatencyHistogram
+{
+public:
+	LatencyHistogram() { reset(); }
+
+	void reset();
+
+	//add one latency measured with cv::getTickCount
+	void addTicks(int64 ticks);
+	void add(uint64_t ns);
+
+	uint64_t count() const { return total; }
+	double mean() const { return total ? (double)sum / total : 0; }
+	uint64_t max() const { return maximum; }
+
+	//latency (ns) below which a fraction 'p' (0..1) of the samples fall
+	uint64_t percentile(double p) const;
+
+private:
+	static int bucketOf(uint64_t ns);
+	static uint64_t bucketUpperBound(int bucket);
+
+	uint64_t counts[HIST_BUCKETS];
+	uint64_t total, sum, maximum;
+};
+
+/// Stages timed per frame. Stages used by the foreground and STATIONARY paths are timed
+/// separately, so every histogram is only written by one thread
+typedef enum {
+	STAGE_DECODE=0,
+	STAGE_MOG2,
+	STAGE_EXTRACT_FG,
+	STAGE_REMOVE_FG,
+	STAGE_CLASSIFY_FG,
+	STAGE_STATIONARY,
+	STAGE_EXTRACT_STAT,
+	STAGE_REMOVE_STAT,
+	STAGE_CLASSIFY_STAT,
+	STAGE_RENDER,
+	STAGE_TRACK_FG,
+	STAGE_TRACK_STAT,
+	NUM_STAGES
+} STAGE;
+
+/// Frame skipped by the rate controller
+struct SkipRecord {
+	int frame;        /* frame number                                   */
+	float late_ms;    /* how late the frame was against its deadline    */
+};
+
+/// Timing of one sequence
+struct PipelineStats {
+	LatencyHistogram stage[NUM_STAGES];
+	int frames;       /* frames processed            */
+	double seconds;   /* wall time of the sequence   */
+	std::vector<SkipRecord> skips; /* frames not analyzed to meet the deadline */
+};
+
+/*
+* Headers of statistics functions
+*
+*/
+
+//name of a stage in the reports
+const char *stageName(int stage);
+
+//clears all the histograms
+void resetStats(PipelineStats &stats);
+
+//prints one line per stage (count, mean, p50, p95, p99, max in milliseconds) and the throughput
+void printStats(const PipelineStats &stats);
+
+//writes the same table as CSV / JSON. Return -1 if the file cannot be written
+int writeStatsCSV(const std::string &path, const PipelineStats &stats);
+int writeStatsJSON(const std::string &path, const PipelineStats &stats);
+
+//writes one CSV row per skipped frame (frame, late_ms)
+int writeSkipLogCSV(const std::string &path, const PipelineStats &stats);
+
+#endif
@@ -0,0 +1,362 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Parallel sweep of the stationary and filtering parameters
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "sweep.hpp"
+#include "maskstream.hpp"
+#include <stdlib.h>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+//values of one parameter: comma separated numbers or first:last:step ranges
+static int parse_values(const std::string &text, std::vector<float> &values)
+{
+	std::stringstream items(text);
+	std::string item;
+	while (std::getline(items, item, ','))
+	{
+		float first, last, step;
+		if (sscanf(item.c_str(), "%f:%f:%f", &first, &last, &step) == 3)
+		{
+			if (step <= 0 || last < first)
+				return -1;
+			//the end is included up to rounding of the step
+			for (int i = 0; first + i*step <= last + step*1e-3f; i++)
+				values.push_back(first + i*step);
+		}
+		else
+		{
+			char *end;
+			float v = strtof(item.c_str(), &end);
+			if (end == item.c_str() || *end != '\0')
+				return -1;
+			values.push_back(v);
+		}
+	}
+	return values.empty() ? -1 : 1;
+}
+
+//true if 'v' is a valid value of parameter 'name': fps and secs > 0, costs from 1 to the
+//saturation of the history (65535), stat_th in (0,1), minimum sizes >= 0
+static bool valid_value(const std::string &name, float v)
+{
+	if (!std::isfinite(v))
+		return false;
+	if (name == "fps" || name == "secs")
+		return v > 0;
+	if (name == "i_cost" || name == "d_cost")
+		return v >= 1 && v <= 65535;
+	if (name == "stat_th")
+		return v > 0 && v < 1;
+	return v >= 0 && v <= 65535; //min_width, min_height
+}
+
+/**
+ *	Parses the parameter grid of a sweep: "name=values" entries separated by ';'. Values
+ *	out of the range of their parameter (see valid_value) are rejected.
+ *
+ * \param spec Grid, e.g. "secs=5,10,15;i_cost=3:7:2;stat_th=0.45,0.5,0.55"
+ * \param grid Values of each parameter (parameters not in 'spec' are left empty)
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int parseSweepGrid(const std::string &spec, SweepGrid &grid)
+{
+	grid = SweepGrid();
+	std::stringstream entries(spec);
+	std::string entry;
+	while (std::getline(entries, entry, ';'))
+	{
+		if (entry.empty())
+			continue;
+		size_t eq = entry.find('=');
+		std::string name = entry.substr(0, eq);
+		std::vector<float> *values = NULL;
+		if (name == "fps") values = &grid.fps;
+		else if (name == "secs") values = &grid.secs_stationary;
+		else if (name == "i_cost") values = &grid.i_cost;
+		else if (name == "d_cost") values = &grid.d_cost;
+		else if (name == "stat_th") values = &grid.stat_th;
+		else if (name == "min_width") values = &grid.min_width;
+		else if (name == "min_height") values = &grid.min_height;
+
+		if (!values || eq == std::string::npos || parse_values(entry.substr(eq+1), *values) < 0){
+			std::cout << "Wrong sweep parameter " << entry << std::endl;
+			return -1;
+		}
+		for (size_t i = 0; i < values->size(); i++)
+			if (!valid_value(name, (*values)[i])){
+				std::cout << "Sweep value out of range: " << name << "=" << (*values)[i] << std::endl;
+				return -1;
+			}
+	}
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Expands a grid into one config per combination of its values (the last parameter
+ *	changes fastest). Parameters without values keep the value of 'base'.
+ *
+ * \param grid Values of each parameter
+ * \param base Settings of the sequence
+ * \param configs Configs of the combinations
+ */
+void expandSweepGrid(const SweepGrid &grid, const PipelineConfig &base, std::vector<PipelineConfig> &configs)
+{
+	//axes of the grid in the order of the table columns
+	const std::vector<float> *axes[7] = { &grid.fps, &grid.secs_stationary, &grid.i_cost, &grid.d_cost,
+			&grid.stat_th, &grid.min_width, &grid.min_height };
+	size_t pos[7] = {0};
+
+	configs.clear();
+	for (;;)
+	{
+		PipelineConfig config = base;
+		for (int a = 0; a < 7; a++)
+		{
+			if (axes[a]->empty())
+				continue;
+			float v = (*axes[a])[pos[a]];
+			switch (a)
+			{
+			case 0: config.stationary.fps = v; break;
+			case 1: config.stationary.secs_stationary = v; break;
+			case 2: config.stationary.i_cost = (int)lroundf(v); break;
+			case 3: config.stationary.d_cost = (int)lroundf(v); break;
+			case 4: config.stationary.stat_th = v; break;
+			case 5: config.min_width = (int)lroundf(v); break;
+			case 6: config.min_height = (int)lroundf(v); break;
+			}
+		}
+		configs.push_back(config);
+
+		//next combination
+		int a = 6;
+		for (; a >= 0; a--)
+		{
+			if (++pos[a] < std::max<size_t>(1, axes[a]->size()))
+				break;
+			pos[a] = 0;
+		}
+		if (a < 0)
+			break;
+	}
+}
+
+/**
+ *	Decodes a sequence and runs MOG2 on every frame (no frame is skipped), keeping the
+ *	masks for a sweep.
+ *
+ * \param source Opened frame source
+ * \param config Settings of the sequence (analysis_scale and learningrate)
+ * \param sequence Masks of the sequence
+ *
+ * \return Number of masks
+ */
+int loadSweepSequence(FrameSource &source, const PipelineConfig &config, SweepSequence &sequence)
+{
+	Ptr<BackgroundSubtractor> pMOG2 = cv::createBackgroundSubtractorMOG2();
+	Mat frame, small, fgmask;
+	sequence.masks.clear();
+	sequence.scale = std::max(1, config.analysis_scale);
+
+	while (source.read(frame) && frame.data)
+	{
+		const Mat *analysis_frame = &frame;
+		if (sequence.scale > 1)
+		{
+			resize(frame, small, Size(frame.cols / sequence.scale, frame.rows / sequence.scale), 0, 0, INTER_AREA);
+			analysis_frame = &small;
+		}
+		pMOG2->apply(*analysis_frame, fgmask, config.learningrate);
+
+		SweepMask mask;
+		mask.index = (int)sequence.masks.size() + 1;
+		encodeMaskRLE(fgmask, mask.rle);
+		sequence.masks.push_back(mask);
+		sequence.size = fgmask.size();
+	}
+	return (int)sequence.masks.size();
+}
+
+/**
+ *	Reads the masks of a recorded stream for a sweep (see --record-masks).
+ *
+ * \param replay Opened mask stream
+ * \param sequence Masks of the sequence, at the scale they were recorded at
+ *
+ * \return Number of masks
+ */
+int loadSweepSequence(MaskReplay &replay, SweepSequence &sequence)
+{
+	sequence.masks.clear();
+	sequence.size = replay.size;
+	sequence.scale = replay.scale;
+
+	//records are checked but not decoded (each worker decodes its own copy)
+	int index;
+	while (readMaskRecord(replay, index))
+	{
+		SweepMask mask;
+		mask.index = index;
+		mask.rle.swap(replay.payload);
+		sequence.masks.push_back(mask);
+	}
+	return (int)sequence.masks.size();
+}
+
+//analysis of all the masks of a sequence with one config
+static SweepResult sweepConfig(const SweepSequence &sequence, const PipelineConfig &config)
+{
+	SweepResult result = SweepResult();
+	result.first_stationary = -1;
+	int64 start = getTickCount();
+
+	MaskAnalysis analysis;
+	initTracker(analysis.tracker);
+	initTracker(analysis.stracker);
+	PipelineStats stats;
+	resetStats(stats);
+	FrameData data;
+	data.skipped = false;
+	data.fgmask.create(sequence.size, CV_8UC1);
+
+	int last_index = 0;
+	for (size_t m = 0; m < sequence.masks.size(); m++)
+	{
+		const SweepMask &mask = sequence.masks[m];
+		if (decodeMaskRLE(mask.rle.data(), mask.rle.size(), data.fgmask) < 0)
+			break;
+		data.index = mask.index;
+		data.frames_elapsed = last_index ? std::max(1, mask.index - last_index) : 1;
+		last_index = mask.index;
+
+		analyzeMask(analysis, config, sequence.scale, data, stats, getTickCount());
+
+		result.frames++;
+		result.fg_blobs += (long)data.bloblistFiltered.size();
+		result.stat_blobs += (long)data.sbloblistFiltered.size();
+		for (size_t i = 0; i < data.sbloblistFiltered.size(); i++)
+			result.stat_by_class[data.sbloblistFiltered[i].label]++;
+		if (result.first_stationary < 0 && !data.sbloblistFiltered.empty())
+			result.first_stationary = mask.index;
+		result.stat_fraction += (double)countNonZero(data.sfgmask) / data.sfgmask.total();
+	}
+	if (result.frames)
+		result.stat_fraction /= result.frames;
+	result.stat_tracks = analysis.stracker.next_id - 1;
+	result.seconds = (getTickCount() - start) / getTickFrequency();
+	return result;
+}
+
+/**
+ *	Evaluates every config of a sweep on the shared masks of a sequence, on a bounded pool
+ *	of worker threads (each one takes the next pending config, as runBatch does with the
+ *	sequences). Each config has its own stationary history and trackers.
+ *
+ * \param sequence Masks of the sequence (read-only, shared by the workers)
+ * \param configs Configs to evaluate
+ * \param num_workers Maximum number of configs evaluated at the same time (0 uses all the cores)
+ * \param results Outcome of each config, in the order of 'configs'
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int runSweep(const SweepSequence &sequence, const std::vector<PipelineConfig> &configs, int num_workers, std::vector<SweepResult> &results)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (sequence.masks.empty() || configs.empty()){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	if (num_workers <= 0)
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	num_workers = std::min(num_workers, (int)configs.size());
+
+	results.assign(configs.size(), SweepResult());
+	std::atomic<int> next(0);
+
+	std::vector<std::thread> workers;
+	for (int w = 0; w < num_workers; w++)
+		workers.push_back(std::thread([&]{
+			for (int c = next++; c < (int)configs.size(); c = next++)
+				results[c] = sweepConfig(sequence, configs[c]);
+		}));
+	for (size_t w = 0; w < workers.size(); w++)
+		workers[w].join();
+
+	//return OK code
+	return 1;
+}
+
+/**
+ *	Sweep of one sequence: its masks are computed (or read) once and every config is
+ *	evaluated on them with runSweep.
+ *
+ * \param input Video file or image pattern of the sequence
+ * \param output_dir Results directory of the sequence (with fgmask.rle if config.replay_masks)
+ * \param config Settings of the sequence (input, MOG2 and replay settings)
+ * \param configs Configs to evaluate
+ * \param num_workers Maximum number of configs evaluated at the same time (0 uses all the cores)
+ * \param results Outcome of each config, in the order of 'configs'
+ *
+ * \return Number of masks of the sequence (negative if not succesfull operation)
+ */
+int sweepSequence(const std::string &input, const std::string &output_dir, const PipelineConfig &config,
+		const std::vector<PipelineConfig> &configs, int num_workers, std::vector<SweepResult> &results)
+{
+	SweepSequence sequence;
+	if (config.replay_masks)
+	{
+		MaskReplay replay;
+		if (openMaskReplay(output_dir + "/fgmask.rle", replay) < 0)
+			return -1;
+		loadSweepSequence(replay, sequence);
+		closeMaskReplay(replay);
+	}
+	else
+	{
+		Ptr<FrameSource> source = openFrameSource(input, config.prefetch, config.decode_workers);
+		if (!source){
+			std::cout << "Could not open video file " << input << std::endl;
+			return -1;
+		}
+		loadSweepSequence(*source, config, sequence);
+	}
+
+	if (runSweep(sequence, configs, num_workers, results) < 0)
+		return -1;
+	return (int)sequence.masks.size();
+}
+
+void writeSweepHeader(FILE *table)
+{
+	fprintf(table, "sequence,fps,secs,i_cost,d_cost,stat_th,min_width,min_height,frames,fg_blobs,stat_blobs,stat_tracks,"
+			"first_stationary,stat_fraction,stat_unknown,stat_person,stat_group,stat_car,stat_object,ms_per_frame\n");
+}
+
+void writeSweepRows(FILE *table, const std::string &sequence, const std::vector<PipelineConfig> &configs, const std::vector<SweepResult> &results)
+{
+	for (size_t c = 0; c < configs.size() && c < results.size(); c++)
+	{
+		const StationaryParams &p = configs[c].stationary;
+		const SweepResult &r = results[c];
+		fprintf(table, "%s,%g,%g,%d,%d,%g,%d,%d,%d,%ld,%ld,%d,%d,%.6f", sequence.c_str(), p.fps, p.secs_stationary,
+				p.i_cost, p.d_cost, p.stat_th, configs[c].min_width, configs[c].min_height,
+				r.frames, r.fg_blobs, r.stat_blobs, r.stat_tracks, r.first_stationary, r.stat_fraction);
+		for (int k = 0; k < NUM_CLASSES; k++)
+			fprintf(table, ",%ld", r.stat_by_class[k]);
+		fprintf(table, ",%.3f\n", r.frames ? 1000*r.seconds/r.frames : 0);
+	}
+	fflush(table);
+}
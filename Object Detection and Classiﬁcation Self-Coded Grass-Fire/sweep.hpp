@@ -0,0 +1,96 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Parallel sweep of the stationary and filtering parameters
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class SweepGrid
+ * \brief Grid of values of the stationary detection and blob filtering parameters
+ *
+ * The MOG2 masks of a sequence do not depend on FPS, SECS_STATIONARY, I_COST, D_COST,
+ * STAT_TH nor on the minimum blob size, so a sweep decodes the sequence and runs MOG2 once
+ * (or reads the masks recorded with --record-masks) and then evaluates every combination of
+ * the grid on those shared masks, several combinations at the same time. Masks are kept in
+ * memory run-length encoded (see encodeMaskRLE) and each worker decodes its own copy.
+ * Every combination gives one row of the sweep table.
+ */
+
+#ifndef SWEEP_H_INCLUDE
+#define SWEEP_H_INCLUDE
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "pipeline.hpp"
+
+/// Values of each swept parameter (a parameter not given keeps the value of the base config)
+struct SweepGrid {
+	std::vector<float> fps;
+	std::vector<float> secs_stationary;
+	std::vector<float> i_cost;
+	std::vector<float> d_cost;
+	std::vector<float> stat_th;
+	std::vector<float> min_width;
+	std::vector<float> min_height;
+};
+
+/// Foreground mask of a sequence shared by the combinations of a sweep
+struct SweepMask {
+	int index;                 /* frame number                        */
+	std::vector<uchar> rle;    /* mask encoded with encodeMaskRLE     */
+};
+
+/// Masks of a sequence decoded once for a sweep
+struct SweepSequence {
+	std::vector<SweepMask> masks;
+	Size size;                 /* size of the masks                   */
+	int scale;                 /* analysis scale of the masks         */
+};
+
+/// Outcome of one combination of a sweep on one sequence
+struct SweepResult {
+	int frames;                /* masks analyzed                                        */
+	long fg_blobs;             /* filtered foreground blobs, summed over the frames     */
+	long stat_blobs;           /* filtered STATIONARY blobs, summed over the frames     */
+	long stat_by_class[NUM_CLASSES]; /* STATIONARY blobs of each class                  */
+	int stat_tracks;           /* STATIONARY tracks (distinct stationary objects)       */
+	int first_stationary;      /* first frame with a STATIONARY blob (-1: none)         */
+	double stat_fraction;      /* mean fraction of stationary pixels per frame          */
+	double seconds;            /* time to analyze the masks                             */
+};
+
+/*
+* Headers of sweep functions
+*
+*/
+
+//parses a grid like "secs=5,10,15;i_cost=3:7:2;stat_th=0.45,0.5,0.55" (lists of values or
+//first:last:step ranges; parameters fps, secs, i_cost, d_cost, stat_th, min_width, min_height)
+int parseSweepGrid(const std::string &spec, SweepGrid &grid);
+
+//one config per combination of the grid, copies of 'base' with the swept parameters set
+void expandSweepGrid(const SweepGrid &grid, const PipelineConfig &base, std::vector<PipelineConfig> &configs);
+
+//decodes 'source' and runs MOG2 once (at config.analysis_scale), or reads the masks of 'replay'
+int loadSweepSequence(FrameSource &source, const PipelineConfig &config, SweepSequence &sequence);
+int loadSweepSequence(MaskReplay &replay, SweepSequence &sequence);
+
+//evaluates every config on the masks of 'sequence' with at most 'num_workers' at the same time
+int runSweep(const SweepSequence &sequence, const std::vector<PipelineConfig> &configs, int num_workers, std::vector<SweepResult> &results);
+
+//loads a sequence (the masks of <output_dir>/fgmask.rle if config.replay_masks, else 'input')
+//and evaluates every config on it. Returns the number of masks (-1 if it cannot be loaded)
+int sweepSequence(const std::string &input, const std::string &output_dir, const PipelineConfig &config,
+		const std::vector<PipelineConfig> &configs, int num_workers, std::vector<SweepResult> &results);
+
+//sweep table: header line and one line per config of a sequence
+void writeSweepHeader(FILE *table);
+void writeSweepRows(FILE *table, const std::string &sequence, const std::vector<PipelineConfig> &configs, const std::vector<SweepResult> &results);
+
+#endif
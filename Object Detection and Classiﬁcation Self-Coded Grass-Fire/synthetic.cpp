@@ -0,0 +1,61 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Synthetic foreground masks for benchmarks and tests of the blob kernels
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "synthetic.hpp"
+#include <math.h>
+#include <algorithm>
+
+/**
+ *	Synthetic foreground mask. 'nblobs' rectangles or ellipses with aspect ratios between
+ *	0.3 (person) and 1.5 (car) are drawn at random positions, sized so that together they
+ *	cover 'density' of the image (less if they overlap). The bottom 'shadow' fraction of the
+ *	rows of each blob is drawn as shadow (127). SHAPE_NOISE sets every pixel independently.
+ *	The same spec always gives the same mask.
+ */
+Mat syntheticMask(const MaskSpec &spec)
+{
+	Mat mask = Mat::zeros(spec.size, CV_8UC1);
+	RNG rng(spec.seed);
+
+	if (spec.shape == SHAPE_NOISE)
+	{
+		for (int y = 0; y < mask.rows; y++)
+		{
+			uchar *row = mask.ptr<uchar>(y);
+			for (int x = 0; x < mask.cols; x++)
+				if (rng.uniform(0.0, 1.0) < spec.density)
+					row[x] = (rng.uniform(0.0, 1.0) < spec.shadow) ? 127 : 255;
+		}
+		return mask;
+	}
+
+	double blob_area = spec.density * mask.total() / std::max(1, spec.nblobs);
+	for (int i = 0; i < spec.nblobs; i++)
+	{
+		double aspect = rng.uniform(0.3, 1.5); //w/h
+		int w = std::max(1, std::min(mask.cols, (int)sqrt(blob_area * aspect)));
+		int h = std::max(1, std::min(mask.rows, (int)(w / aspect)));
+		int x0 = rng.uniform(0, mask.cols - w + 1), y0 = rng.uniform(0, mask.rows - h + 1);
+		int shadow_row = h - (int)(h * spec.shadow);
+		for (int y = 0; y < h; y++)
+		{
+			uchar *row = mask.ptr<uchar>(y0 + y);
+			uchar value = (y >= shadow_row) ? 127 : 255;
+			double dy = (y + 0.5) / h - 0.5;
+			for (int x = 0; x < w; x++)
+			{
+				double dx = (x + 0.5) / w - 0.5;
+				if (spec.shape == SHAPE_ELLIPSE && dx*dx + dy*dy > 0.25)
+					continue;
+				row[x0 + x] = value;
+			}
+		}
+	}
+	return mask;
+}
@@ -0,0 +1,43 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Synthetic foreground masks for benchmarks and tests of the blob kernels
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#ifndef SYNTHETIC_H_INCLUDE
+#define SYNTHETIC_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+
+using namespace cv;
+
+/// Blob shapes of the synthetic masks
+typedef enum {
+	SHAPE_RECT=0,
+	SHAPE_ELLIPSE=1,
+	SHAPE_NOISE=2    /* independent random pixels (worst case for labeling) */
+} SHAPE;
+
+/// Parameters of a synthetic mask
+struct MaskSpec {
+	Size size;
+	double density;  /* target fraction of foreground (255 or 127) pixels     */
+	int nblobs;      /* blobs drawn (not used by SHAPE_NOISE)                  */
+	SHAPE shape;
+	double shadow;   /* fraction of the rows of each blob drawn as shadow (127) */
+	uint64_t seed;
+};
+
+/*
+* Headers of synthetic mask functions
+*
+*/
+
+//deterministic mask of 'spec' (blobs of 255 with shadows of 127 over a background of 0)
+Mat syntheticMask(const MaskSpec &spec);
+
+#endif
@@ -0,0 +1,188 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Blob tracking across frames
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+#include "tracker.hpp"
+#include <algorithm>
+
+//max cells per grid side; with tracks spread further apart the cells grow beyond max_distance
+#define MAX_GRID_CELLS 256
+
+void initTracker(BlobTracker &tracker, float max_distance, int max_missed, float label_decay)
+{
+	tracker.tracks.clear();
+	tracker.next_id = 1;
+	tracker.max_distance = max_distance;
+	tracker.max_missed = max_missed;
+	tracker.label_decay = label_decay;
+}
+
+//label with the highest vote (the current one wins ties, so the label does not flicker)
+static CLASS vote_label(const Track &track)
+{
+	CLASS best = track.label;
+	for (int c = 0; c < NUM_CLASSES; c++)
+		if (track.votes[c] > track.votes[best])
+			best = (CLASS)c;
+	return best;
+}
+
+//new track started by a blob
+static Track track_new(int id, const cvBlob &blob)
+{
+	Track track;
+	track.id = id;
+	track.cx = blob.cx;
+	track.cy = blob.cy;
+	track.vx = track.vy = 0;
+	track.age = 1;
+	track.missed = 0;
+	for (int c = 0; c < NUM_CLASSES; c++)
+		track.votes[c] = 0;
+	track.votes[blob.label] = 1;
+	track.label = blob.label;
+	return track;
+}
+
+/**
+ *	Tracks the blobs of a new frame. Every blob is associated with the closest track
+ *	(predicted centroid: last centroid plus the last displacement) within max_distance;
+ *	pairs are taken closest first and each track takes at most one blob. Blobs left
+ *	over start new tracks and tracks without a blob for more than max_missed frames are
+ *	dropped.
+ *
+ *	The label of each track is a vote of the labels given by classifyBlobs, where past
+ *	votes decay by label_decay every frame, so a blob needs several frames of a new label
+ *	to change class.
+ *
+ * \param tracker Tracker state (updated)
+ * \param bloblist Classified blobs of the frame. ID is set to the track ID and label to the smoothed label
+ *
+ * \return Operation code (negative if not succesfull operation)
+ */
+int trackBlobs(BlobTracker &tracker, std::vector<cvBlob> &bloblist)
+{
+	//check input conditions and return -1 if any is not satisfied
+	if (tracker.max_distance <= 0 || tracker.next_id < 1){
+		std::cout<<"Variables are not initialized" << std::endl;
+		return -1;
+	}
+
+	std::vector<Track> &tracks = tracker.tracks;
+	int num_tracks = (int)tracks.size();
+	int num_blobs = (int)bloblist.size();
+	float max_d2 = tracker.max_distance * tracker.max_distance;
+
+	tracker.pairs.clear();
+	if (num_tracks > 0 && num_blobs > 0)
+	{
+		//grid over the predicted centroids of the tracks
+		float min_x = tracks[0].cx + tracks[0].vx, max_x = min_x;
+		float min_y = tracks[0].cy + tracks[0].vy, max_y = min_y;
+		for (int t = 1; t < num_tracks; t++)
+		{
+			float px = tracks[t].cx + tracks[t].vx, py = tracks[t].cy + tracks[t].vy;
+			min_x = std::min(min_x, px); max_x = std::max(max_x, px);
+			min_y = std::min(min_y, py); max_y = std::max(max_y, py);
+		}
+		float cell = std::max(tracker.max_distance, std::max(max_x - min_x, max_y - min_y) / (MAX_GRID_CELLS - 1));
+		int cols = (int)((max_x - min_x) / cell) + 1;
+		int rows = (int)((max_y - min_y) / cell) + 1;
+
+		//tracks sorted by cell (counting sort)
+		tracker.cell_start.assign(cols * rows + 1, 0);
+		tracker.track_cell.resize(num_tracks);
+		for (int t = 0; t < num_tracks; t++)
+		{
+			int gx = (int)((tracks[t].cx + tracks[t].vx - min_x) / cell);
+			int gy = (int)((tracks[t].cy + tracks[t].vy - min_y) / cell);
+			tracker.track_cell[t] = gy * cols + gx;
+			tracker.cell_start[tracker.track_cell[t] + 1]++;
+		}
+		for (int c = 0; c < cols * rows; c++)
+			tracker.cell_start[c + 1] += tracker.cell_start[c];
+		tracker.cell_tracks.resize(num_tracks);
+		tracker.cell_fill.assign(tracker.cell_start.begin(), tracker.cell_start.end() - 1);
+		for (int t = 0; t < num_tracks; t++)
+			tracker.cell_tracks[tracker.cell_fill[tracker.track_cell[t]]++] = t;
+
+		//candidate pairs: tracks in the 3x3 cells around each blob
+		for (int b = 0; b < num_blobs; b++)
+		{
+			float bx = bloblist[b].cx, by = bloblist[b].cy;
+			int gx = (int)std::floor((bx - min_x) / cell);
+			int gy = (int)std::floor((by - min_y) / cell);
+			for (int y = std::max(0, gy - 1); y <= std::min(rows - 1, gy + 1); y++)
+				for (int x = std::max(0, gx - 1); x <= std::min(cols - 1, gx + 1); x++)
+				{
+					int c = y * cols + x;
+					for (int k = tracker.cell_start[c]; k < tracker.cell_start[c + 1]; k++)
+					{
+						const Track &track = tracks[tracker.cell_tracks[k]];
+						float dx = bx - (track.cx + track.vx), dy = by - (track.cy + track.vy);
+						float d2 = dx*dx + dy*dy;
+						if (d2 <= max_d2)
+							tracker.pairs.push_back(std::make_pair(d2, std::make_pair(b, tracker.cell_tracks[k])));
+					}
+				}
+		}
+	}
+
+	//greedy association, closest pairs first
+	std::sort(tracker.pairs.begin(), tracker.pairs.end());
+	tracker.blob_track.assign(num_blobs, -1);
+	tracker.track_used.assign(num_tracks, 0);
+	for (size_t p = 0; p < tracker.pairs.size(); p++)
+	{
+		int b = tracker.pairs[p].second.first, t = tracker.pairs[p].second.second;
+		if (tracker.blob_track[b] >= 0 || tracker.track_used[t])
+			continue;
+		tracker.blob_track[b] = t;
+		tracker.track_used[t] = 1;
+	}
+
+	//update the associated tracks and age the others
+	for (int t = 0; t < num_tracks; t++)
+		if (!tracker.track_used[t])
+			tracks[t].missed++;
+	for (int b = 0; b < num_blobs; b++)
+	{
+		cvBlob &blob = bloblist[b];
+		int t = tracker.blob_track[b];
+		if (t < 0)
+		{
+			blob.ID = tracker.next_id++;
+			tracks.push_back(track_new(blob.ID, blob));
+			continue;
+		}
+		Track &track = tracks[t];
+		track.vx = blob.cx - track.cx;
+		track.vy = blob.cy - track.cy;
+		track.cx = blob.cx;
+		track.cy = blob.cy;
+		track.age++;
+		track.missed = 0;
+		for (int c = 0; c < NUM_CLASSES; c++)
+			track.votes[c] *= tracker.label_decay;
+		track.votes[blob.label] += 1;
+		track.label = vote_label(track);
+
+		blob.ID = track.id;
+		blob.label = track.label;
+	}
+
+	//drop the tracks lost for too long
+	size_t kept = 0;
+	for (size_t t = 0; t < tracks.size(); t++)
+		if (tracks[t].missed <= tracker.max_missed)
+			tracks[kept++] = tracks[t];
+	tracks.resize(kept);
+
+	//return OK code
+	return 1;
+}
@@ -0,0 +1,73 @@
+/* Applied Video Analysis of Sequences (AVSA)
+ *
+ *	LAB2: Blob detection & classification
+ *	Blob tracking across frames
+ *
+ *
+ * Authors: José M. Martínez (josem.martinez@uam.es), Paula Moral (paula.moral@uam.es), Juan C. San Miguel (juancarlos.sanmiguel@uam.es)
+ */
+
+ //class description
+/**
+ * \class BlobTracker
+ * \brief Persistent track IDs and temporally smoothed class labels for the blobs of a sequence
+ *
+ * Each frame the classified blobs are associated with the tracks of the previous frame by
+ * nearest centroid (greedy, closest pairs first, within 'max_distance' pixels of the
+ * predicted position). Candidate pairs are found through a uniform grid of cells of
+ * 'max_distance' pixels over the predicted centroids, so only the tracks in the 3x3 cells
+ * around a blob are compared and association stays near-linear in the number of blobs.
+ */
+
+#ifndef TRACKER_H_INCLUDE
+#define TRACKER_H_INCLUDE
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "blobs.hpp"
+
+/// Number of values of CLASS
+const int NUM_CLASSES = OBJECT + 1;
+
+/// One tracked blob
+struct Track {
+	int   id;                     /* track ID (from 1, never reused)               */
+	float cx, cy;                 /* centroid in the last frame it was seen        */
+	float vx, vy;                 /* centroid displacement per frame               */
+	int   age;                    /* frames since the track started                */
+	int   missed;                 /* consecutive frames without an associated blob */
+	float votes[NUM_CLASSES];     /* decayed count of the labels given to the blob */
+	CLASS label;                  /* smoothed label (highest vote)                 */
+};
+
+/// State of the tracker of one blob list (e.g. foreground or STATIONARY blobs)
+struct BlobTracker {
+	std::vector<Track> tracks;
+	int   next_id;                /* ID of the next track                          */
+	float max_distance;           /* max centroid distance to associate (pixels)   */
+	int   max_missed;             /* frames a track survives without blobs         */
+	float label_decay;            /* weight of past labels in the vote (0..1)      */
+
+	//association buffers, kept between frames to avoid allocations
+	std::vector<int> cell_start;  /* first entry of each grid cell in cell_tracks  */
+	std::vector<int> cell_fill;   /* next free entry of each cell while sorting    */
+	std::vector<int> cell_tracks; /* track indices sorted by cell                  */
+	std::vector<int> track_cell;  /* cell of each track                            */
+	std::vector<std::pair<float, std::pair<int,int> > > pairs; /* (distance^2, (blob, track)) */
+	std::vector<int> blob_track;  /* associated track of each blob (-1: none)      */
+	std::vector<uchar> track_used;
+};
+
+/*
+* Headers of tracking functions
+*
+*/
+
+//resets the tracker (no tracks, IDs from 1)
+void initTracker(BlobTracker &tracker, float max_distance=50.f, int max_missed=5, float label_decay=0.9f);
+
+//associates the blobs of a new frame with the tracks: sets ID to the track ID and label to the smoothed label
+int trackBlobs(BlobTracker &tracker, std::vector<cvBlob> &bloblist);
+
+#endif